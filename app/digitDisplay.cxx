@@ -1,3 +1,6 @@
+#include "TDigitIndex.hxx"
+#include "TChannelTable.hxx"
+
 #include <TROOT.h>
 
 #include <TEvent.hxx>
@@ -6,7 +9,8 @@
 #include <THandle.hxx>
 #include <TCaptLog.hxx>
 #include <TChannelId.hxx>
-#include <TMCChannelId.hxx>
+#include <TChannelInfo.hxx>
+#include <TManager.hxx>
 
 #include <eventLoop.hxx>
 
@@ -56,23 +60,28 @@ public:
             startTime = std::min(startTime, pulse->GetFirstSample());
         }
 
-        int signalEnd = startTime;
-        for (CP::TDigitContainer::const_iterator d = drift->begin();
-             d != drift->end(); ++d) {
-            const CP::TPulseDigit* pulse 
-                = dynamic_cast<const CP::TPulseDigit*>(*d);
-            if (!pulse) continue;
-            signalEnd = std::max(signalEnd, pulse->GetFirstSample());
-        }
+        // Sort the drift digits into the wire planes once, and then draw each
+        // plane from the index.
+        CP::TChannelInfo::Get().SetContext(event.GetContext());
+        CP::TManager::Get().Geometry();
+        CP::TChannelTable::Get().SetEvent(event);
+        CP::TDigitIndex index(*drift);
 
-        int signalStart = signalEnd;
-        for (CP::TDigitContainer::const_iterator d = drift->begin();
-             d != drift->end(); ++d) {
-            const CP::TPulseDigit* pulse 
-                = dynamic_cast<const CP::TPulseDigit*>(*d);
-            if (!pulse) continue;
-            signalStart = std::min(signalStart, pulse->GetFirstSample());
+        int signalEnd = startTime;
+        int signalStart = -1;
+        for (int plane = 0; plane < CP::TDigitIndex::kPlaneCount; ++plane) {
+            const std::vector<CP::TDigitIndex::Digit>& wires
+                = index.GetPlane(plane);
+            for (std::vector<CP::TDigitIndex::Digit>::const_iterator d
+                     = wires.begin(); d != wires.end(); ++d) {
+                if (!d->fPulse) continue;
+                int first = d->fPulse->GetFirstSample();
+                signalEnd = std::max(signalEnd, first);
+                if (signalStart < 0) signalStart = first;
+                signalStart = std::min(signalStart, first);
+            }
         }
+        if (signalStart < 0) signalStart = signalEnd;
 
         int center = (signalEnd+signalStart)/2;
         int spread = 0.66*(signalEnd-signalStart);
@@ -93,127 +102,37 @@ public:
         gStyle->SetOptStat(false);
         std::string drawOption("colz");
 
-        double maxWire = 0;
-        double minWire = 10000;
-        for (CP::TDigitContainer::const_iterator d = drift->begin();
-             d != drift->end(); ++d) {
-            const CP::TPulseDigit* pulse 
-                = dynamic_cast<const CP::TPulseDigit*>(*d);
-            if (!pulse) continue;
-            double wire=-1;
-            if (pulse->GetChannelId().IsMCChannel()) {
-                CP::TMCChannelId mc(pulse->GetChannelId());
-                wire = mc.GetNumber();
-                if (mc.GetSequence() != 0) continue;
-            }
-            minWire = std::min(minWire,wire);
-            maxWire = std::max(maxWire,wire);
-        }
-
-        TH2F* xPlane 
-            = new TH2F("xPlane", "Charge on the X wires",
-                       maxWire-minWire+1, minWire, maxWire+1,
-                       2*spread,center-spread,center+spread);        
-        for (CP::TDigitContainer::const_iterator d = drift->begin();
-             d != drift->end(); ++d) {
-            const CP::TPulseDigit* pulse 
-                = dynamic_cast<const CP::TPulseDigit*>(*d);
-            if (!pulse) continue;
-            double wire = -1;
-            if (pulse->GetChannelId().IsMCChannel()) {
-                CP::TMCChannelId mc(pulse->GetChannelId());
-                wire = mc.GetNumber()+0.5;
-                if (mc.GetSequence() != 0) continue;
-            }
-            for (std::size_t i = 0; i < pulse->GetSampleCount(); ++i) {
-                int tbin = pulse->GetFirstSample() + i;
-                xPlane->Fill(wire,tbin+0.5,pulse->GetSample(i)-2000.0);
-            }
-        }
-        xPlane->Draw(drawOption.c_str());
-        gPad->Print("xplane.png");
-
-
-        maxWire = 0;
-        minWire = 10000;
-        for (CP::TDigitContainer::const_iterator d = drift->begin();
-             d != drift->end(); ++d) {
-            const CP::TPulseDigit* pulse 
-                = dynamic_cast<const CP::TPulseDigit*>(*d);
-            if (!pulse) continue;
-            double wire=-1;
-            if (pulse->GetChannelId().IsMCChannel()) {
-                CP::TMCChannelId mc(pulse->GetChannelId());
-                wire = mc.GetNumber();
-                if (mc.GetSequence() != 1) continue;
-            }
-            minWire = std::min(minWire,wire);
-            maxWire = std::max(maxWire,wire);
-        }
-
-        TH2F* uPlane 
-            = new TH2F("uPlane", "Charge on the U wires",
-                       maxWire-minWire+1, minWire, maxWire+1,
-                       2*spread,center-spread,center+spread);        
-        for (CP::TDigitContainer::const_iterator d = drift->begin();
-             d != drift->end(); ++d) {
-            const CP::TPulseDigit* pulse 
-                = dynamic_cast<const CP::TPulseDigit*>(*d);
-            if (!pulse) continue;
-            double wire = -1;
-            if (pulse->GetChannelId().IsMCChannel()) {
-                CP::TMCChannelId mc(pulse->GetChannelId());
-                wire = mc.GetNumber()+0.5;
-                if (mc.GetSequence() != 1) continue;
-            }
-            for (std::size_t i = 0; i < pulse->GetSampleCount(); ++i) {
-                int tbin = pulse->GetFirstSample() + i;
-                uPlane->Fill(wire,tbin+0.5,pulse->GetSample(i)-2000.0);
-            }
-        }
-        uPlane->Draw(drawOption.c_str());
-        gPad->Print("uplane.png");
-
-
-        maxWire = 0;
-        minWire = 10000;
-        for (CP::TDigitContainer::const_iterator d = drift->begin();
-             d != drift->end(); ++d) {
-            const CP::TPulseDigit* pulse 
-                = dynamic_cast<const CP::TPulseDigit*>(*d);
-            if (!pulse) continue;
-            double wire=-1;
-            if (pulse->GetChannelId().IsMCChannel()) {
-                CP::TMCChannelId mc(pulse->GetChannelId());
-                wire = mc.GetNumber();
-                if (mc.GetSequence() != 2) continue;
-            }
-            minWire = std::min(minWire,wire);
-            maxWire = std::max(maxWire,wire);
-        }
-
-        TH2F* vPlane 
-            = new TH2F("vPlane", "Charge on the V wires",
-                       maxWire-minWire+1, minWire, maxWire+1,
-                       2*spread,center-spread,center+spread);        
-        for (CP::TDigitContainer::const_iterator d = drift->begin();
-             d != drift->end(); ++d) {
-            const CP::TPulseDigit* pulse 
-                = dynamic_cast<const CP::TPulseDigit*>(*d);
-            if (!pulse) continue;
-            double wire = -1;
-            if (pulse->GetChannelId().IsMCChannel()) {
-                CP::TMCChannelId mc(pulse->GetChannelId());
-                wire = mc.GetNumber()+0.5;
-                if (mc.GetSequence() != 2) continue;
-            }
-            for (std::size_t i = 0; i < pulse->GetSampleCount(); ++i) {
-                int tbin = pulse->GetFirstSample() + i;
-                vPlane->Fill(wire,tbin+0.5,pulse->GetSample(i)-2000.0);
+        const char* names[CP::TDigitIndex::kPlaneCount] = {"x", "v", "u"};
+        const char* titles[CP::TDigitIndex::kPlaneCount] = {
+            "Charge on the X wires",
+            "Charge on the V wires",
+            "Charge on the U wires"};
+        for (int plane = 0; plane < CP::TDigitIndex::kPlaneCount; ++plane) {
+            const std::vector<CP::TDigitIndex::Digit>& wires
+                = index.GetPlane(plane);
+            if (wires.empty()) continue;
+
+            // The digits are sorted by wire number.
+            double minWire = wires.front().fWire;
+            double maxWire = wires.back().fWire;
+
+            std::string name = std::string(names[plane]) + "Plane";
+            TH2F* hist 
+                = new TH2F(name.c_str(), titles[plane],
+                           maxWire-minWire+1, minWire, maxWire+1,
+                           2*spread,center-spread,center+spread);        
+            for (std::vector<CP::TDigitIndex::Digit>::const_iterator d
+                     = wires.begin(); d != wires.end(); ++d) {
+                if (!d->fPulse) continue;
+                double wire = d->fWire + 0.5;
+                for (std::size_t i = 0; i < d->fPulse->GetSampleCount(); ++i) {
+                    int tbin = d->fPulse->GetFirstSample() + i;
+                    hist->Fill(wire,tbin+0.5,d->fPulse->GetSample(i)-2000.0);
+                }
             }
+            hist->Draw(drawOption.c_str());
+            gPad->Print((std::string(names[plane]) + "plane.png").c_str());
         }
-        vPlane->Draw(drawOption.c_str());
-        gPad->Print("vplane.png");
 
         return true;
     }
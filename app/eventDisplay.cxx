@@ -1,8 +1,11 @@
 #include "TEventDisplay.hxx"
 #include "TEventChangeManager.hxx"
+#include "TChainedInput.hxx"
+#include "TDisplayTimer.hxx"
 
 #include <TCaptLog.hxx>
 #include <TRootInput.hxx>
+#include <TRuntimeParameters.hxx>
 #include <TVInputFile.hxx>
 
 #include <TROOT.h>
@@ -12,12 +15,43 @@
 #include <getopt.h>
 
 #include <iostream>
+#include <cstdlib>
 #include <memory>
+#include <vector>
+#include <string>
+
+/// Print the timing report when the event display exits.
+void PrintTimingAtExit() {
+    CP::TDisplayTimer::PrintReport(std::cout);
+}
+
+/// Finish the trace file when the event display exits.
+void CloseTraceAtExit() {
+    CP::TDisplayTimer::CloseTrace();
+}
 
 void usage() {
-    std::cout << "Usage: event-display.exe [input-file] " << std::endl;
+    std::cout << "Usage: event-display.exe [input-file ...] " << std::endl;
     std::cout << "    The event display: " << std::endl;
+    std::cout << "    Several input files (or a quoted glob pattern) are"
+              << std::endl
+              << "    chained together and shown as a single file."
+              << std::endl;
     std::cout << "  -g    Toggle showing the geometry." << std::endl;
+    std::cout << "  -p <n>"
+              << std::endl
+              << "        Prefetch n events around the current event"
+              << std::endl;
+    std::cout << "  -f    Follow a file that is being written and show"
+              << std::endl
+              << "        the newest event."
+              << std::endl;
+    std::cout << "  -t    Time the event display, and print a report on exit."
+              << std::endl;
+    std::cout << "  -T <file>"
+              << std::endl
+              << "        Write a Chrome trace-event (JSON) file"
+              << std::endl;
     std::cout << "  -c    Set the log configuration file." << std::endl;
     std::cout << "  -d    Increase the debug level"
               << std::endl;
@@ -36,18 +70,35 @@ void usage() {
 int main(int argc, char **argv) {
     std::string fileName = "";
     bool showGeometry = false;
+    bool followFile = false;
+    int prefetchDepth = 0;
     int debugLevel = 0;
     std::map<std::string, CP::TCaptLog::ErrorPriority> namedDebugLevel;
     int logLevel = -1; // Will choose default logging level...
     std::map<std::string, CP::TCaptLog::LogPriority> namedLogLevel;
     char *configName = NULL;
     while (1) {
-        int c = getopt(argc, argv, "?hgdD:vV:c:");
+        int c = getopt(argc, argv, "?hgfp:tT:dD:vV:c:");
         if (c == -1) break;
         switch (c) {
         case 'g': // Show the geometry.
             showGeometry = not showGeometry;
             break;
+        case 'f': // Follow the newest event in the file.
+            followFile = true;
+            break;
+        case 't': // Time the event display.
+            CP::TDisplayTimer::SetEnabled(true);
+            std::atexit(PrintTimingAtExit);
+            break;
+        case 'T': // Write a trace file.
+            if (CP::TDisplayTimer::OpenTrace(optarg)) {
+                std::atexit(CloseTraceAtExit);
+            }
+            break;
+        case 'p': // Set the number of events to prefetch.
+            prefetchDepth = std::atoi(optarg);
+            break;
         case 'c': {
             configName = strdup(optarg);
             break;
@@ -174,15 +225,37 @@ int main(int argc, char **argv) {
         CP::TCaptLog::SetDebugLevel(i->first.c_str(), i->second);
     }
          
-    // Check if there is an input file on the command line.
-    if (argc - optind > 0) {
-        fileName = argv[optind];
+    // Check if there are input files on the command line.
+    std::vector<std::string> fileNames;
+    for (int i = optind; i < argc; ++i) fileNames.push_back(argv[i]);
+    if (fileNames.size() == 1
+        && fileNames[0].find_first_of("*?[") == std::string::npos) {
+        fileName = fileNames[0];
+    }
+
+    if (followFile && fileName.empty()) {
+        usage();
+        CaptError("Can only follow a single input file");
+        return 1;
     }
 
     CP::TVInputFile* eventSource = NULL;
     if (!fileName.empty()) {
         eventSource = new CP::TRootInput(fileName.c_str());
     }
+    else if (!fileNames.empty()) {
+        // Chain several files (or the files matching a pattern).
+        CP::TChainedInput* chain = new CP::TChainedInput();
+        chain->SetMaxOpenFiles(
+            CP::TRuntimeParameters::Get().GetParameterI(
+                "eventDisplay.chain.openFiles"));
+        for (std::vector<std::string>::iterator f = fileNames.begin();
+             f != fileNames.end(); ++f) {
+            chain->AddFiles(*f);
+        }
+        if (chain->GetFileCount() > 0) eventSource = chain;
+        else delete chain;
+    }
     if (!eventSource) {
         usage();
         CaptError("Must provide an input file");
@@ -194,6 +267,12 @@ int main(int argc, char **argv) {
 
     CP::TEventDisplay& ev = CP::TEventDisplay::Get();
     ev.EventChange().SetShowGeometry(showGeometry);
+    ev.EventChange().SetPrefetchDepth(prefetchDepth);
+    if (followFile) {
+        ev.EventChange().SetFollowInterval(
+            CP::TRuntimeParameters::Get().GetParameterI(
+                "eventDisplay.follow.milliseconds"));
+    }
     ev.EventChange().SetEventSource(eventSource);
 
     theApp.Run(kFALSE);
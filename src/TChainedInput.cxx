@@ -0,0 +1,150 @@
+#include "TChainedInput.hxx"
+#include "TEventTree.hxx"
+
+#include <TCaptLog.hxx>
+#include <TEvent.hxx>
+
+#include <glob.h>
+
+#include <algorithm>
+
+CP::TChainedInput::TChainedInput()
+    : fEntries(0), fPosition(-1), fMaxOpenFiles(4), fUseCount(0) {}
+
+CP::TChainedInput::~TChainedInput() {
+    CloseFile();
+}
+
+int CP::TChainedInput::AddFiles(const std::string& pattern) {
+    std::vector<std::string> names;
+    glob_t matches;
+    if (glob(pattern.c_str(), 0, NULL, &matches) == 0) {
+        for (std::size_t i = 0; i < matches.gl_pathc; ++i) {
+            names.push_back(matches.gl_pathv[i]);
+        }
+    }
+    globfree(&matches);
+    if (names.empty()) {
+        CaptError("No input files match " << pattern);
+        return 0;
+    }
+    std::sort(names.begin(), names.end());
+
+    // Each file is opened long enough to count the entries, so the entry
+    // numbering is known before any event is read.
+    int added = 0;
+    for (std::vector<std::string>::iterator n = names.begin();
+         n != names.end(); ++n) {
+        CP::TEventTree* tree = new CP::TEventTree(*n);
+        int entries = tree->GetEntryCount();
+        delete tree;
+        if (entries < 1) {
+            CaptWarn("Skip input file without events: " << *n);
+            continue;
+        }
+        File file;
+        file.fName = *n;
+        file.fTree = NULL;
+        file.fFirstEntry = fEntries;
+        file.fEntries = entries;
+        file.fLastUse = 0;
+        fFiles.push_back(file);
+        fEntries += entries;
+        ++added;
+        CaptLog("Chain " << *n << " with " << entries << " entries");
+    }
+    return added;
+}
+
+void CP::TChainedInput::SetMaxOpenFiles(int files) {
+    fMaxOpenFiles = std::max(1,files);
+    CloseIdleFiles();
+}
+
+int CP::TChainedInput::FindFile(int entry) const {
+    if (entry < 0 || entry >= fEntries) return -1;
+    // Find the last file starting at or before the entry.
+    int low = 0;
+    int high = fFiles.size() - 1;
+    while (low < high) {
+        int mid = (low + high + 1)/2;
+        if (fFiles[mid].fFirstEntry <= entry) low = mid;
+        else high = mid - 1;
+    }
+    return low;
+}
+
+void CP::TChainedInput::CloseIdleFiles() {
+    while (true) {
+        int open = 0;
+        int idle = -1;
+        for (std::size_t i = 0; i < fFiles.size(); ++i) {
+            if (!fFiles[i].fTree) continue;
+            ++open;
+            if (idle < 0 || fFiles[i].fLastUse < fFiles[idle].fLastUse) {
+                idle = i;
+            }
+        }
+        if (open <= fMaxOpenFiles || idle < 0) break;
+        CaptVerbose("Close idle input file " << fFiles[idle].fName);
+        delete fFiles[idle].fTree;
+        fFiles[idle].fTree = NULL;
+    }
+}
+
+CP::TEventTree* CP::TChainedInput::GetFileTree(int file) {
+    if (file < 0 || file >= (int) fFiles.size()) return NULL;
+    File& chained = fFiles[file];
+    chained.fLastUse = ++fUseCount;
+    if (!chained.fTree) {
+        CaptVerbose("Open input file " << chained.fName);
+        chained.fTree = new CP::TEventTree(chained.fName);
+        CloseIdleFiles();
+    }
+    if (!chained.fTree->IsOpen()) return NULL;
+    return chained.fTree;
+}
+
+CP::TEvent* CP::TChainedInput::ReadEvent(int entry) {
+    int file = FindFile(entry);
+    if (file < 0) return NULL;
+    CP::TEventTree* tree = GetFileTree(file);
+    if (!tree) return NULL;
+    CP::TEvent* event = tree->ReadEvent(entry - fFiles[file].fFirstEntry);
+    if (event) fPosition = entry;
+    return event;
+}
+
+const char* CP::TChainedInput::GetInputName() const {
+    if (fFiles.empty()) return "";
+    return fFiles.front().fName.c_str();
+}
+
+CP::TEvent* CP::TChainedInput::FirstEvent() {
+    return ReadEvent(0);
+}
+
+CP::TEvent* CP::TChainedInput::NextEvent(int skip) {
+    return ReadEvent(fPosition + skip + 1);
+}
+
+CP::TEvent* CP::TChainedInput::PreviousEvent(int skip) {
+    return ReadEvent(fPosition - skip - 1);
+}
+
+bool CP::TChainedInput::IsOpen() {
+    return !fFiles.empty();
+}
+
+bool CP::TChainedInput::EndOfFile() {
+    return fPosition + 1 >= fEntries;
+}
+
+void CP::TChainedInput::CloseFile() {
+    for (std::vector<File>::iterator f = fFiles.begin();
+         f != fFiles.end(); ++f) {
+        if (!f->fTree) continue;
+        delete f->fTree;
+        f->fTree = NULL;
+    }
+}
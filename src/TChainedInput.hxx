@@ -0,0 +1,124 @@
+#ifndef TChainedInput_hxx_seen
+#define TChainedInput_hxx_seen
+
+#include <TVInputFile.hxx>
+
+#include <vector>
+#include <string>
+
+namespace CP {
+    class TChainedInput;
+    class TEventTree;
+    class TEvent;
+};
+
+/// An input source that chains several ROOT event files together so that
+/// they can be read as if they were a single file.  The entries are numbered
+/// consecutively across the files (in the order the files were added), and
+/// the stepping interface crosses file boundaries.
+///
+/// The files are only opened when an entry is read from them, and the least
+/// recently used files are closed so that at most GetMaxOpenFiles() are open
+/// at once.  This bounds the number of file descriptors (and the memory used
+/// by the open trees) for runs that are split across many files.  The
+/// events are read directly from the trees (see TEventTree), so they aren't
+/// registered in the event folder.
+class CP::TChainedInput : public CP::TVInputFile {
+public:
+    TChainedInput();
+    virtual ~TChainedInput();
+
+    /// Add the files matching a name to the chain.  The name can be a glob
+    /// pattern (e.g. "run0123_*.root"), and the matching files are added in
+    /// sorted order.  This returns the number of files that were added.
+    int AddFiles(const std::string& pattern);
+
+    /// Set the maximum number of files that are held open.
+    void SetMaxOpenFiles(int files);
+
+    /// Get the maximum number of files that are held open.
+    int GetMaxOpenFiles() const {return fMaxOpenFiles;}
+
+    /// Get the number of files in the chain.
+    int GetFileCount() const {return fFiles.size();}
+
+    /// Get the name of a file in the chain.
+    const std::string& GetFileName(int file) const {
+        return fFiles[file].fName;
+    }
+
+    /// Get the first entry (counted across the chain) of a file.
+    int GetFirstEntry(int file) const {return fFiles[file].fFirstEntry;}
+
+    /// Get the number of entries in a file.
+    int GetFileEntries(int file) const {return fFiles[file].fEntries;}
+
+    /// Find the file holding an entry.  This returns -1 if the entry isn't
+    /// in the chain.
+    int FindFile(int entry) const;
+
+    /// Get the tree of events for a file in the chain, opening it if
+    /// necessary.  The tree is owned by the chain, and may be closed the
+    /// next time another file is opened.  This returns NULL if the events
+    /// can't be read.
+    CP::TEventTree* GetFileTree(int file);
+
+    /// Get the total number of entries in the chain.
+    int GetEventsInFile() const {return fEntries;}
+
+    /// Read an entry (counted across the chain).  This returns NULL if the
+    /// entry can't be read.  The event isn't in the event folder, and must
+    /// be deleted by the caller.
+    CP::TEvent* ReadEvent(int entry);
+
+    /// The TVInputFile interface.  The input name of the chain is the name
+    /// of the first file.
+    virtual const char* GetInputName() const;
+    virtual CP::TEvent* FirstEvent();
+    virtual CP::TEvent* NextEvent(int skip=0);
+    virtual CP::TEvent* PreviousEvent(int skip=0);
+    virtual int GetPosition() const {return fPosition;}
+    virtual bool IsOpen();
+    virtual bool EndOfFile();
+    virtual void CloseFile();
+
+private:
+
+    /// A file in the chain.
+    struct File {
+        /// The name of the file.
+        std::string fName;
+
+        /// The tree of events for the file (NULL if the file is closed).
+        CP::TEventTree* fTree;
+
+        /// The first entry of the file counted across the chain.
+        int fFirstEntry;
+
+        /// The number of entries in the file.
+        int fEntries;
+
+        /// When the file was last used (a count of file accesses).
+        unsigned long fLastUse;
+    };
+
+    /// Close the least recently used files so that there is room to open
+    /// another one.
+    void CloseIdleFiles();
+
+    /// The files in the chain.
+    std::vector<File> fFiles;
+
+    /// The total number of entries in the chain.
+    int fEntries;
+
+    /// The entry of the last event read, or -1.
+    int fPosition;
+
+    /// The maximum number of files held open.
+    int fMaxOpenFiles;
+
+    /// A counter for the file accesses used to find the idle files.
+    unsigned long fUseCount;
+};
+#endif
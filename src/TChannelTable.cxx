@@ -0,0 +1,80 @@
+#include "TChannelTable.hxx"
+
+#include <TCaptLog.hxx>
+#include <CaptGeomId.hxx>
+#include <TEvent.hxx>
+#include <TEventContext.hxx>
+#include <TChannelInfo.hxx>
+#include <TChannelCalib.hxx>
+#include <TGeometryInfo.hxx>
+
+#include <sstream>
+
+CP::TChannelTable* CP::TChannelTable::fTable = NULL;
+
+CP::TChannelTable& CP::TChannelTable::Get() {
+    if (!fTable) fTable = new CP::TChannelTable();
+    return *fTable;
+}
+
+CP::TChannelTable::TChannelTable()
+    : fMask(0), fShift(32), fValid(false), fRun(-1), fMC(false) {}
+
+void CP::TChannelTable::SetEvent(const CP::TEvent& event) {
+    const CP::TEventContext& context = event.GetContext();
+    std::ostringstream hash;
+    hash << event.GetGeometryHash();
+    if (fValid && context.GetRun() == fRun && context.IsMC() == fMC
+        && hash.str() == fGeometry) return;
+    fRun = context.GetRun();
+    fMC = context.IsMC();
+    fGeometry = hash.str();
+    Build();
+
+    // An empty table is rebuilt for the next event.
+    fValid = !fChannels.empty();
+}
+
+void CP::TChannelTable::Build() {
+    fChannels.clear();
+    fSlots.clear();
+
+    CP::TChannelCalib chanCalib;
+    for (int plane = 0; plane < 3; ++plane) {
+        int wireCount = CP::TGeometryInfo::Get().GetWireCount(plane);
+        for (int wire = 0; wire < wireCount; ++wire) {
+            CP::TGeometryId id = CP::GeomId::Captain::Wire(plane,wire);
+            CP::TChannelId cid = CP::TChannelInfo::Get().GetChannel(id);
+            if (!cid.IsValid()) continue;
+            Channel channel;
+            channel.fChannelId = cid;
+            channel.fGeomId = id;
+            channel.fPlane = plane;
+            channel.fWire = wire;
+            channel.fGood = chanCalib.IsGoodWire(id);
+            channel.fTimeOffset = chanCalib.GetTimeConstant(cid,0);
+            channel.fTimeStep = chanCalib.GetTimeConstant(cid,1);
+            fChannels.push_back(channel);
+        }
+    }
+    if (fChannels.empty()) {
+        CaptError("No wire channels for run " << fRun);
+        return;
+    }
+
+    // Keep the hash table less than half full.
+    int bits = 1;
+    while ((1u << bits) < 2*fChannels.size()) ++bits;
+    fSlots.resize(1u << bits, -1);
+    fMask = (1u << bits) - 1;
+    fShift = 32 - bits;
+    for (std::size_t i = 0; i < fChannels.size(); ++i) {
+        unsigned int key = fChannels[i].fChannelId.AsUInt();
+        unsigned int slot = Hash(key);
+        while (fSlots[slot] >= 0) slot = (slot + 1) & fMask;
+        fSlots[slot] = i;
+    }
+
+    CaptLog("Channel table with " << fChannels.size()
+            << " wires for run " << fRun << " and geometry " << fGeometry);
+}
@@ -0,0 +1,118 @@
+#ifndef TChannelTable_hxx_seen
+#define TChannelTable_hxx_seen
+
+#include <TChannelId.hxx>
+#include <TGeometryId.hxx>
+
+#include <vector>
+#include <string>
+
+namespace CP {
+    class TChannelTable;
+    class TEvent;
+};
+
+/// A table of the wire channels with the information the plotters need for
+/// each digit: the wire plane and number, the good wire flag, and the time
+/// constants.  The table is filled once from TChannelInfo and TChannelCalib
+/// and then a channel is found by indexing an open addressed hash table
+/// instead of querying the channel database.
+///
+/// The table is rebuilt when the calibration context or the geometry
+/// changes.  The calibrations don't advertise their validity ranges, so the
+/// context is taken to change when the run, or the MC flag, of the event
+/// changes.  The wires are found in the geometry, so the table is also
+/// rebuilt when the geometry hash changes.  TEventChangeManager::UpdateEvent()
+/// sets the event after the geometry for the event is loaded.
+class CP::TChannelTable {
+public:
+    /// The information kept for a wire channel.
+    struct Channel {
+        /// The channel id.
+        CP::TChannelId fChannelId;
+
+        /// The geometry id of the wire.
+        CP::TGeometryId fGeomId;
+
+        /// The wire plane (0 is X, 1 is V, and 2 is U).
+        int fPlane;
+
+        /// The wire number in the plane.
+        int fWire;
+
+        /// True if the wire is good.
+        bool fGood;
+
+        /// The time constants for the channel.  The time offset is order
+        /// zero, and the time per sample is order one.
+        double fTimeOffset;
+        double fTimeStep;
+    };
+
+    /// Get the table.
+    static CP::TChannelTable& Get();
+
+    /// Set the event.  The table is rebuilt if the calibrations or the
+    /// geometry might have changed, or if the last build didn't find any
+    /// wires.  The TChannelInfo context must already be set, and the
+    /// geometry for the event must already be loaded (see
+    /// TManager::Geometry()).
+    void SetEvent(const CP::TEvent& event);
+
+    /// Find a channel.  This returns NULL if the channel isn't a wire, or
+    /// the table hasn't been built.
+    const Channel* Find(CP::TChannelId id) const {
+        if (fSlots.empty()) return NULL;
+        unsigned int key = id.AsUInt();
+        unsigned int slot = Hash(key);
+        while (fSlots[slot] >= 0) {
+            const Channel& channel = fChannels[fSlots[slot]];
+            if (channel.fChannelId.AsUInt() == key) return &channel;
+            slot = (slot + 1) & fMask;
+        }
+        return NULL;
+    }
+
+    /// Get the number of channels in the table.
+    int GetChannelCount() const {return fChannels.size();}
+
+private:
+    TChannelTable();
+
+    /// Fill the table for the current context.
+    void Build();
+
+    /// Find the first slot for a channel.
+    unsigned int Hash(unsigned int key) const {
+        return (key*2654435761u) >> fShift & fMask;
+    }
+
+    /// The channels in the table.
+    std::vector<Channel> fChannels;
+
+    /// The open addressed hash table of indices into fChannels.  Empty
+    /// slots are -1, and the size is a power of two.
+    std::vector<int> fSlots;
+
+    /// The mask for a slot index.
+    unsigned int fMask;
+
+    /// The shift to take the high bits of the hashed key.
+    int fShift;
+
+    /// True if the table has been built (and has wires) for an event.
+    bool fValid;
+
+    /// The run of the context the table was built for.
+    int fRun;
+
+    /// The MC flag of the context the table was built for.
+    bool fMC;
+
+    /// The geometry hash of the event the table was built for.
+    std::string fGeometry;
+
+    /// The only instance of the table.
+    static CP::TChannelTable* fTable;
+};
+#endif
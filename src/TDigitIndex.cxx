@@ -0,0 +1,110 @@
+#include "TDigitIndex.hxx"
+#include "TChannelTable.hxx"
+
+#include <TCaptLog.hxx>
+#include <HEPUnits.hxx>
+#include <CaptGeomId.hxx>
+#include <TDigitContainer.hxx>
+#include <TChannelInfo.hxx>
+#include <TChannelCalib.hxx>
+
+#include <algorithm>
+
+namespace {
+    /// Order the digits by wire number.
+    bool WireOrder(const CP::TDigitIndex::Digit& a,
+                   const CP::TDigitIndex::Digit& b) {
+        return a.fWire < b.fWire;
+    }
+};
+
+double CP::TDigitIndex::Digit::GetFirstTime() const {
+    if (fPulse) return fPulse->GetFirstSample();
+    if (fCalib) return fCalib->GetFirstSample()/unit::microsecond;
+    return 0.0;
+}
+
+double CP::TDigitIndex::Digit::GetLastTime() const {
+    if (fPulse) return fPulse->GetFirstSample()+fPulse->GetSampleCount();
+    if (fCalib) return fCalib->GetLastSample()/unit::microsecond;
+    return 0.0;
+}
+
+double CP::TDigitIndex::Digit::GetSampleStep() const {
+    double diff = GetLastTime() - GetFirstTime();
+    return diff/GetSampleCount();
+}
+
+CP::TDigitIndex::TDigitIndex() {}
+
+CP::TDigitIndex::TDigitIndex(const CP::TDigitContainer& digits) {
+    Build(digits);
+}
+
+void CP::TDigitIndex::Clear() {
+    for (int p = 0; p < kPlaneCount; ++p) fPlanes[p].clear();
+}
+
+void CP::TDigitIndex::Build(const CP::TDigitContainer& digits) {
+    Clear();
+    const CP::TChannelTable& table = CP::TChannelTable::Get();
+    bool useTable = table.GetChannelCount() > 0;
+    if (!useTable) {
+        CaptWarn("Channel table not built, use the channel database");
+    }
+    CP::TChannelCalib chanCalib;
+    for (CP::TDigitContainer::const_iterator d = digits.begin();
+         d != digits.end(); ++d) {
+        const CP::TDigit* digit = dynamic_cast<const CP::TDigit*>(*d);
+        if (!digit) continue;
+        Digit entry;
+        int plane = -1;
+        if (useTable) {
+            const CP::TChannelTable::Channel* channel
+                = table.Find(digit->GetChannelId());
+            if (!channel) continue;
+            plane = channel->fPlane;
+            entry.fGeomId = channel->fGeomId;
+            entry.fWire = channel->fWire;
+            entry.fGood = channel->fGood;
+            entry.fTimeOffset = channel->fTimeOffset;
+            entry.fTimeStep = channel->fTimeStep;
+        }
+        else {
+            CP::TGeometryId id
+                = CP::TChannelInfo::Get().GetGeometry(digit->GetChannelId());
+            plane = CP::GeomId::Captain::GetWirePlane(id);
+            entry.fGeomId = id;
+            entry.fWire = CP::GeomId::Captain::GetWireNumber(id);
+            entry.fGood = chanCalib.IsGoodWire(id);
+            entry.fTimeOffset
+                = chanCalib.GetTimeConstant(digit->GetChannelId(),0);
+            entry.fTimeStep
+                = chanCalib.GetTimeConstant(digit->GetChannelId(),1);
+        }
+        if (plane < 0 || plane >= kPlaneCount) continue;
+        entry.fDigit = digit;
+        entry.fPulse = dynamic_cast<const CP::TPulseDigit*>(digit);
+        entry.fCalib = NULL;
+        if (!entry.fPulse) {
+            entry.fCalib = dynamic_cast<const CP::TCalibPulseDigit*>(digit);
+        }
+        fPlanes[plane].push_back(entry);
+    }
+    for (int p = 0; p < kPlaneCount; ++p) {
+        std::stable_sort(fPlanes[p].begin(), fPlanes[p].end(), WireOrder);
+    }
+    CaptVerbose("Digit index with " << GetDigitCount() << " digits");
+}
+
+const std::vector<CP::TDigitIndex::Digit>&
+CP::TDigitIndex::GetPlane(int plane) const {
+    if (plane < 0 || plane >= kPlaneCount) return fEmpty;
+    return fPlanes[plane];
+}
+
+std::size_t CP::TDigitIndex::GetDigitCount() const {
+    std::size_t count = 0;
+    for (int p = 0; p < kPlaneCount; ++p) count += fPlanes[p].size();
+    return count;
+}
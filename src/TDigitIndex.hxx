@@ -0,0 +1,118 @@
+#ifndef TDigitIndex_hxx_seen
+#define TDigitIndex_hxx_seen
+
+#include <TGeometryId.hxx>
+#include <TPulseDigit.hxx>
+#include <TCalibPulseDigit.hxx>
+
+#include <vector>
+#include <cstddef>
+
+namespace CP {
+    class TDigitIndex;
+    class TDigit;
+    class TDigitContainer;
+};
+
+/// An index of the drift digits in an event sorted into the wire planes.
+/// The digits are classified in one pass when the index is built: the
+/// wire and calibration information is looked up once for each digit in
+/// the TChannelTable, and the type of the digit is found so that the
+/// samples can be read without a cast.  The plotters get the index for the
+/// current event from TEventChangeManager::GetDigitIndex() so that drawing
+/// the X, V and U planes only classifies the digits once.
+class CP::TDigitIndex {
+public:
+    /// The number of wire planes.
+    enum {kPlaneCount = 3};
+
+    /// A digit in the index.
+    struct Digit {
+        /// The digit.
+        const CP::TDigit* fDigit;
+
+        /// The digit if it's a raw pulse, otherwise NULL.
+        const CP::TPulseDigit* fPulse;
+
+        /// The digit if it's a calibrated pulse, otherwise NULL.
+        const CP::TCalibPulseDigit* fCalib;
+
+        /// The geometry id of the wire.
+        CP::TGeometryId fGeomId;
+
+        /// The wire number in the plane.
+        int fWire;
+
+        /// True if the wire is good.
+        bool fGood;
+
+        /// The time constants of the channel (see TChannelTable).
+        double fTimeOffset;
+        double fTimeStep;
+
+        /// The number of samples.
+        std::size_t GetSampleCount() const {
+            if (fPulse) return fPulse->GetSampleCount();
+            if (fCalib) return fCalib->GetSampleCount();
+            return 0;
+        }
+
+        /// Get a sample.  Loops over the samples should use Apply() so
+        /// that the type isn't checked for every sample.
+        double GetSample(std::size_t i) const {
+            if (fPulse) return fPulse->GetSample(i);
+            if (fCalib) return fCalib->GetSample(i);
+            return 0;
+        }
+
+        /// Apply a kernel to the digit as its concrete type.  The kernel
+        /// is a class with an operator () that is templated on the digit
+        /// type, so the sample loop is compiled separately for the raw
+        /// (integer ADC) and calibrated (float charge) pulses, and runs
+        /// without a cast or a virtual call for each sample.  The kernel
+        /// isn't called for other types of digit.
+        template <class K> void Apply(K& kernel) const {
+            if (fPulse) kernel(*fPulse);
+            else if (fCalib) kernel(*fCalib);
+        }
+
+        /// The time of the first sample.  This is the sample number for a
+        /// raw pulse, and the time in microseconds for a calibrated pulse.
+        double GetFirstTime() const;
+
+        /// The time after the last sample (see GetFirstTime()).
+        double GetLastTime() const;
+
+        /// The time between samples (see GetFirstTime()).
+        double GetSampleStep() const;
+    };
+
+    /// Make an empty index.
+    TDigitIndex();
+
+    /// Make the index for a digit container.
+    explicit TDigitIndex(const CP::TDigitContainer& digits);
+
+    /// Classify the digits in a container.  The previous contents are
+    /// replaced.
+    void Build(const CP::TDigitContainer& digits);
+
+    /// Remove all of the digits.
+    void Clear();
+
+    /// Get the digits for a wire plane (0 is X, 1 is V, and 2 is U) sorted
+    /// by wire number.
+    const std::vector<Digit>& GetPlane(int plane) const;
+
+    /// Get the number of digits in the index.
+    std::size_t GetDigitCount() const;
+
+private:
+
+    /// The digits in each plane.
+    std::vector<Digit> fPlanes[kPlaneCount];
+
+    /// Returned for a plane that doesn't exist.
+    std::vector<Digit> fEmpty;
+};
+#endif
@@ -0,0 +1,194 @@
+#include "TDisplayTimer.hxx"
+
+#include <TCaptLog.hxx>
+
+#include <TMutex.h>
+#include <TVirtualMutex.h>
+#include <TThread.h>
+
+#include <time.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <vector>
+
+bool CP::TDisplayTimer::fEnabled = false;
+bool CP::TDisplayTimer::fTracing = false;
+
+namespace {
+    /// The number of recent times kept for each activity.
+    const std::size_t gWindow = 200;
+
+    /// The statistics for an activity.
+    struct TimerStatistics {
+        TimerStatistics() : fCount(0), fNext(0) {}
+
+        /// The number of times the activity has been timed.
+        long fCount;
+
+        /// The most recent time.
+        double fLast;
+
+        /// The most recent times (a ring buffer).
+        std::vector<double> fTimes;
+
+        /// The next slot to fill in the ring buffer.
+        std::size_t fNext;
+    };
+
+    typedef std::map<std::string, TimerStatistics> Statistics;
+
+    /// The statistics for each activity.
+    Statistics gStatistics;
+
+    /// Protect the statistics.  This is created when timing is first turned
+    /// on.
+    TMutex* gStatisticsMutex = NULL;
+
+    /// The trace file (NULL if there isn't one).
+    std::ofstream* gTraceFile = NULL;
+
+    /// The time that the trace was started.
+    double gTraceStart = 0.0;
+
+    /// True until the first event is written to the trace.
+    bool gTraceFirst = true;
+
+    /// The short thread numbers used in the trace, indexed by thread id.
+    std::map<Long_t, int> gTraceThreads;
+
+    /// Protect the trace file.  This is created when the trace is opened.
+    TMutex* gTraceMutex = NULL;
+};
+
+void CP::TDisplayTimer::SetEnabled(bool enabled) {
+    if (enabled && !gStatisticsMutex) gStatisticsMutex = new TMutex();
+    fEnabled = enabled;
+}
+
+double CP::TDisplayTimer::Now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + 1E-9*now.tv_nsec;
+}
+
+void CP::TDisplayTimer::Start() {
+    fRunning = true;
+    fStart = Now();
+    if (fTracing) WriteTrace("B", fStart);
+}
+
+void CP::TDisplayTimer::Stop() {
+    if (!fRunning) return;
+    fRunning = false;
+    double stop = Now();
+    if (fTracing) WriteTrace("E", stop);
+    if (!fEnabled) return;
+    double elapsed = stop - fStart;
+
+    std::string name(fName);
+    if (fDetail) name = name + " " + fDetail;
+
+    TLockGuard lock(gStatisticsMutex);
+    TimerStatistics& stats = gStatistics[name];
+    ++stats.fCount;
+    stats.fLast = elapsed;
+    if (stats.fTimes.size() < gWindow) {
+        stats.fTimes.push_back(elapsed);
+    }
+    else {
+        stats.fTimes[stats.fNext] = elapsed;
+        stats.fNext = (stats.fNext + 1) % gWindow;
+    }
+}
+
+void CP::TDisplayTimer::PrintReport(std::ostream& out) {
+    if (!gStatisticsMutex) {
+        out << "Event display timing is not enabled" << std::endl;
+        return;
+    }
+    TLockGuard lock(gStatisticsMutex);
+    out << "Event display timing (ms) over the last " << gWindow
+        << " calls" << std::endl;
+    out << std::setw(36) << std::left << "activity" << std::right
+        << std::setw(8) << "count"
+        << std::setw(10) << "last"
+        << std::setw(10) << "mean"
+        << std::setw(10) << "p95" << std::endl;
+    for (Statistics::iterator s = gStatistics.begin();
+         s != gStatistics.end(); ++s) {
+        std::vector<double> times(s->second.fTimes);
+        if (times.empty()) continue;
+        double sum = 0.0;
+        for (std::vector<double>::iterator t = times.begin();
+             t != times.end(); ++t) {
+            sum += *t;
+        }
+        std::size_t rank = (95*times.size())/100;
+        if (rank >= times.size()) rank = times.size()-1;
+        std::nth_element(times.begin(), times.begin()+rank, times.end());
+        out << std::setw(36) << std::left << s->first << std::right
+            << std::setw(8) << s->second.fCount
+            << std::fixed << std::setprecision(2)
+            << std::setw(10) << 1000.0*s->second.fLast
+            << std::setw(10) << 1000.0*sum/times.size()
+            << std::setw(10) << 1000.0*times[rank] << std::endl;
+    }
+}
+
+bool CP::TDisplayTimer::OpenTrace(const std::string& fileName) {
+    if (!gTraceMutex) gTraceMutex = new TMutex();
+    TLockGuard lock(gTraceMutex);
+    if (gTraceFile) return false;
+    std::ofstream* trace = new std::ofstream(fileName.c_str());
+    if (!(*trace)) {
+        CaptError("Cannot open trace file " << fileName);
+        delete trace;
+        return false;
+    }
+    TThread::Initialize();
+    gTraceFile = trace;
+    gTraceStart = Now();
+    gTraceFirst = true;
+    (*gTraceFile) << "[" << std::endl;
+    fTracing = true;
+    CaptLog("Write trace to " << fileName);
+    return true;
+}
+
+void CP::TDisplayTimer::CloseTrace() {
+    if (!gTraceMutex) return;
+    TLockGuard lock(gTraceMutex);
+    if (!gTraceFile) return;
+    fTracing = false;
+    (*gTraceFile) << std::endl << "]" << std::endl;
+    gTraceFile->close();
+    delete gTraceFile;
+    gTraceFile = NULL;
+}
+
+void CP::TDisplayTimer::WriteTrace(const char* phase, double time) {
+    TLockGuard lock(gTraceMutex);
+    if (!gTraceFile) return;
+
+    // Number the threads in the order they are seen so that the trace has
+    // small thread ids.
+    Long_t self = TThread::SelfId();
+    std::map<Long_t,int>::iterator thread = gTraceThreads.find(self);
+    if (thread == gTraceThreads.end()) {
+        int id = gTraceThreads.size() + 1;
+        thread = gTraceThreads.insert(std::make_pair(self,id)).first;
+    }
+
+    if (!gTraceFirst) (*gTraceFile) << "," << std::endl;
+    gTraceFirst = false;
+    (*gTraceFile) << "{\"name\":\"" << fName;
+    if (fDetail) (*gTraceFile) << " " << fDetail;
+    (*gTraceFile) << "\",\"ph\":\"" << phase << "\""
+                  << ",\"ts\":" << std::fixed << std::setprecision(1)
+                  << 1E+6*(time - gTraceStart)
+                  << ",\"pid\":1,\"tid\":" << thread->second << "}";
+}
@@ -0,0 +1,97 @@
+#ifndef TDisplayTimer_hxx_seen
+#define TDisplayTimer_hxx_seen
+
+#include <iostream>
+#include <string>
+
+namespace CP {
+    class TDisplayTimer;
+};
+
+/// A scoped timer for the activities of the event display (reading an
+/// event, running a handler, redrawing the scene, ...).  The timer starts
+/// when it is constructed, and stops when it is destroyed (or when Stop() is
+/// called).  The times are collected into rolling statistics for each
+/// activity which can be printed with PrintReport().
+///
+/// \code
+/// {
+///     CP::TDisplayTimer timer("redraw");
+///     gEve->Redraw3D(kTRUE);
+/// }
+/// \endcode
+///
+/// The timers can also be written to a trace file in the Chrome trace-event
+/// JSON format (see OpenTrace()).  Each timer writes a begin and an end
+/// event that records the thread that it ran on, so the trace can be opened
+/// in a trace viewer (e.g. chrome://tracing) to look at latency spikes and
+/// at the work done in parallel.
+///
+/// Timing and tracing are off by default.  When they're off, a timer only
+/// checks two flags, so timers can be left in the code.  The timers can be
+/// used from any thread.
+class CP::TDisplayTimer {
+public:
+    /// Start timing an activity.  The activity name is the name followed by
+    /// the detail (if it is provided), e.g. ("prepare", "G4Hits").  The
+    /// strings must remain valid until the timer stops.
+    explicit TDisplayTimer(const char* name, const char* detail = NULL)
+        : fName(name), fDetail(detail), fRunning(false) {
+        if (fEnabled || fTracing) Start();
+    }
+
+    /// Stop the timer if it's running.
+    ~TDisplayTimer() {if (fRunning) Stop();}
+
+    /// Stop the timer and save the time for the activity.  This does
+    /// nothing if the timer isn't running.
+    void Stop();
+
+    /// Turn the timing on or off.
+    static void SetEnabled(bool enabled);
+
+    /// Check if timing is on.
+    static bool IsEnabled() {return fEnabled;}
+
+    /// Start writing the timers to a trace file in the Chrome trace-event
+    /// format.  This returns false if the file can't be opened.
+    static bool OpenTrace(const std::string& fileName);
+
+    /// Finish and close the trace file.
+    static void CloseTrace();
+
+    /// Print a table with the last, mean and 95th percentile time of each
+    /// activity.  The statistics are for the most recent times.
+    static void PrintReport(std::ostream& out = std::cout);
+
+private:
+
+    /// Start the timer.
+    void Start();
+
+    /// Get the current time in seconds from an arbitrary start.
+    static double Now();
+
+    /// Write an event to the trace file.  The phase is "B" for begin, or
+    /// "E" for end.
+    void WriteTrace(const char* phase, double time);
+
+    /// The name of the activity.
+    const char* fName;
+
+    /// The detail of the activity (may be NULL).
+    const char* fDetail;
+
+    /// The time when the timer was started.
+    double fStart;
+
+    /// True while the timer is running.
+    bool fRunning;
+
+    /// True if timing is on.
+    static bool fEnabled;
+
+    /// True if a trace file is being written.
+    static bool fTracing;
+};
+#endif
@@ -0,0 +1,167 @@
+#include "TDriftVolume.hxx"
+
+#include <TCaptLog.hxx>
+#include <TGeomIdManager.hxx>
+#include <TManager.hxx>
+#include <CaptGeomId.hxx>
+
+#include <TGeoManager.h>
+#include <TGeoNode.h>
+#include <TGeoVolume.h>
+#include <TGeoBBox.h>
+
+#include <algorithm>
+
+namespace {
+    /// Find the bounding box of a box (with the origin and half lengths)
+    /// in the frame of the matrix.
+    void MatrixBoundingBox(const TGeoMatrix& matrix,
+                           const double origin[3], const double half[3],
+                           double low[3], double high[3]) {
+        for (int corner = 0; corner < 8; ++corner) {
+            double local[3];
+            double master[3];
+            for (int i = 0; i < 3; ++i) {
+                local[i] = origin[i] + ((corner & (1<<i)) ? half[i]: -half[i]);
+            }
+            matrix.LocalToMaster(local,master);
+            for (int i = 0; i < 3; ++i) {
+                if (corner == 0 || master[i] < low[i]) low[i] = master[i];
+                if (corner == 0 || master[i] > high[i]) high[i] = master[i];
+            }
+        }
+    }
+}
+
+CP::TDriftVolume::TDriftVolume()
+    : fGeometry(NULL), fFound(false), fIsBox(false), fIsComposite(false),
+      fShape(NULL) {
+    for (int i = 0; i < 9; ++i) fRotation[i] = (i%4 == 0) ? 1.0: 0.0;
+    for (int i = 0; i < 3; ++i) {
+        fTranslation[i] = 0.0;
+        fLow[i] = 0.0;
+        fHigh[i] = 0.0;
+    }
+}
+
+void CP::TDriftVolume::Build(TGeoManager* geom) {
+    if (geom == fGeometry) return;
+    fGeometry = geom;
+    fFound = false;
+    fDaughters.clear();
+    if (!geom) return;
+
+    geom->PushPath();
+    if (CP::TManager::Get().GeomId().CdId(CP::GeomId::Captain::Drift())) {
+        SetVolume(*geom->GetCurrentMatrix(), *geom->GetCurrentVolume());
+    }
+    geom->PopPath();
+
+    if (!fFound) {
+        CaptError("Drift volume not found in the geometry");
+        return;
+    }
+    CaptLog("Drift volume with " << fDaughters.size()/6 << " daughters"
+            << (fIsBox ? " (box)": ""));
+}
+
+void CP::TDriftVolume::SetVolume(const TGeoMatrix& matrix,
+                                 const TGeoVolume& volume) {
+    const Double_t* rotation = matrix.GetRotationMatrix();
+    const Double_t* translation = matrix.GetTranslation();
+    std::copy(rotation, rotation+9, fRotation);
+    std::copy(translation, translation+3, fTranslation);
+
+    fShape = volume.GetShape();
+    fIsBox = (fShape->IsA() == TGeoBBox::Class());
+    fIsComposite = fShape->IsComposite();
+    const TGeoBBox* box = static_cast<const TGeoBBox*>(fShape);
+    for (int i = 0; i < 3; ++i) {
+        double half = (i == 0) ? box->GetDX():
+            (i == 1) ? box->GetDY(): box->GetDZ();
+        fLow[i] = box->GetOrigin()[i] - half;
+        fHigh[i] = box->GetOrigin()[i] + half;
+    }
+
+    fDaughters.clear();
+    for (int d = 0; d < volume.GetNdaughters(); ++d) {
+        TGeoNode* node = volume.GetNode(d);
+        const TGeoBBox* daughter
+            = static_cast<const TGeoBBox*>(node->GetVolume()->GetShape());
+        double half[3] = {daughter->GetDX(), daughter->GetDY(),
+                          daughter->GetDZ()};
+        double low[3];
+        double high[3];
+        MatrixBoundingBox(*node->GetMatrix(), daughter->GetOrigin(),
+                          half, low, high);
+        fDaughters.insert(fDaughters.end(), low, low+3);
+        fDaughters.insert(fDaughters.end(), high, high+3);
+    }
+    fFound = true;
+}
+
+int CP::TDriftVolume::Classify(double x, double y, double z) const {
+    if (!fFound) return kCheck;
+    double master[3] = {x - fTranslation[0],
+                        y - fTranslation[1],
+                        z - fTranslation[2]};
+    double local[3];
+    for (int i = 0; i < 3; ++i) {
+        local[i] = fRotation[i]*master[0]
+            + fRotation[i+3]*master[1]
+            + fRotation[i+6]*master[2];
+        if (local[i] < fLow[i] || local[i] > fHigh[i]) return kOutside;
+    }
+    if (fIsComposite) return kCheck;
+    if (!fIsBox && !fShape->Contains(local)) return kOutside;
+    for (std::size_t d = 0; d < fDaughters.size(); d += 6) {
+        bool inside = true;
+        for (int i = 0; i < 3; ++i) {
+            if (local[i] < fDaughters[d+i]) inside = false;
+            if (local[i] > fDaughters[d+i+3]) inside = false;
+        }
+        if (inside) return kCheck;
+    }
+    return kInside;
+}
+
+void CP::TDriftVolume::Classify(std::size_t n,
+                                const double* x,
+                                const double* y,
+                                const double* z,
+                                unsigned char* result) const {
+    if (!fFound) {
+        std::fill(result, result+n, (unsigned char) kCheck);
+        return;
+    }
+
+    // Copy the transformation into locals since the result could alias the
+    // members.  The loop has no branches so it can be vectorized.
+    const double r0 = fRotation[0], r1 = fRotation[1], r2 = fRotation[2];
+    const double r3 = fRotation[3], r4 = fRotation[4], r5 = fRotation[5];
+    const double r6 = fRotation[6], r7 = fRotation[7], r8 = fRotation[8];
+    const double t0 = fTranslation[0];
+    const double t1 = fTranslation[1];
+    const double t2 = fTranslation[2];
+    const double lowX = fLow[0], lowY = fLow[1], lowZ = fLow[2];
+    const double highX = fHigh[0], highY = fHigh[1], highZ = fHigh[2];
+    for (std::size_t i = 0; i < n; ++i) {
+        double dx = x[i] - t0;
+        double dy = y[i] - t1;
+        double dz = z[i] - t2;
+        double lx = r0*dx + r3*dy + r6*dz;
+        double ly = r1*dx + r4*dy + r7*dz;
+        double lz = r2*dx + r5*dy + r8*dz;
+        result[i] = (lowX <= lx) & (lx <= highX)
+            & (lowY <= ly) & (ly <= highY)
+            & (lowZ <= lz) & (lz <= highZ);
+    }
+
+    // The bounding box is the answer for a box without daughters.
+    // Otherwise, the points in the bounding box are checked again.
+    if (fIsBox && fDaughters.empty()) return;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (result[i] == kOutside) continue;
+        result[i] = Classify(x[i], y[i], z[i]);
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef TDriftVolume_hxx_seen
+#define TDriftVolume_hxx_seen
+
+#include <TGeoMatrix.h>
+
+#include <vector>
+#include <cstddef>
+
+namespace CP {
+    class TDriftVolume;
+};
+
+class TGeoManager;
+class TGeoShape;
+class TGeoVolume;
+
+/// A cached test of whether a point is in the drift volume.  This gives the
+/// same answer as finding the geometry id with the navigator and comparing
+/// it to GeomId::Captain::Drift(), but only needs the matrix and shape of
+/// the drift volume which are found once per geometry.
+///
+/// A point inside one of the daughters of the drift volume might belong to
+/// a daughter with its own geometry id, so those points are classified as
+/// kCheck and must be given to the navigator.  After Build() is called, the
+/// object is only read, so it can be used from several threads at once.
+/// The only call into ROOT is TGeoShape::Contains() for a drift volume that
+/// isn't a box.  For the primitive shapes, that only reads the shape
+/// parameters and doesn't touch the navigator, so it's safe without the
+/// geometry mutex.  A composite shape keeps per-thread navigation state in
+/// its boolean node, so the points in the bounding box of a composite drift
+/// volume are classified as kCheck instead.
+class CP::TDriftVolume {
+public:
+    /// The classification of a point.
+    enum {kOutside = 0, kInside = 1, kCheck = 2};
+
+    TDriftVolume();
+
+    /// Find the drift volume in a geometry.  This is only redone if the
+    /// geometry has changed since the last call.  This uses the geometry,
+    /// so it must not be called while the geometry is being navigated on
+    /// another thread.
+    void Build(TGeoManager* geom);
+
+    /// Set the drift volume from its global matrix and its volume.  This is
+    /// used by Build(), and can be used directly when the volume has
+    /// already been found.
+    void SetVolume(const TGeoMatrix& matrix, const TGeoVolume& volume);
+
+    /// Classify a point (in the master frame).
+    int Classify(double x, double y, double z) const;
+
+    /// Classify a batch of points (in the master frame).  The coordinates
+    /// are in separate arrays so that the transformation to the drift frame
+    /// and the bounding box test run over all of the points at once.  The
+    /// points are in double precision so that a point near the boundary is
+    /// classified exactly as it is by Classify(x,y,z) and by the navigator.
+    void Classify(std::size_t n,
+                  const double* x, const double* y, const double* z,
+                  unsigned char* result) const;
+
+private:
+
+    /// The geometry used to find the drift volume.
+    TGeoManager* fGeometry;
+
+    /// True if the drift volume was found.
+    bool fFound;
+
+    /// True if the drift shape is a box so that the bounding box test is
+    /// exact.
+    bool fIsBox;
+
+    /// True if the drift shape is a composite shape (see the class
+    /// description).
+    bool fIsComposite;
+
+    /// The shape of the drift volume.
+    const TGeoShape* fShape;
+
+    /// The rotation (row major) and translation of the global matrix.
+    double fRotation[9];
+    double fTranslation[3];
+
+    /// The bounding box of the shape in the drift frame.
+    double fLow[3];
+    double fHigh[3];
+
+    /// The bounding boxes of the daughters in the drift frame.  Each box
+    /// is six values (the low corner, then the high corner).
+    std::vector<double> fDaughters;
+};
+#endif
@@ -0,0 +1,99 @@
+#ifndef TEveElementPool_hxx_seen
+#define TEveElementPool_hxx_seen
+
+#include <TEveElement.h>
+
+#include <vector>
+
+namespace CP {
+    template <class T> class TEveElementPool;
+};
+
+/// A pool of EVE elements that are reused from event to event.  The handlers
+/// draw thousands of lines for every event, and destroying and recreating
+/// them churns the heap (and fragments it during long shifts).  The pool
+/// keeps the elements (and their point storage) alive between events so
+/// that they can be refilled instead.
+///
+/// \code
+/// fPool.Reset();
+/// for (...) {
+///     TEveLine* line = fPool.Get();
+///     line->SetLineColor(kYellow);
+///     ...
+/// }
+/// \endcode
+///
+/// Each element returned by Get() has been added to the parent.  The parent
+/// must only hold elements from the pool, since Reset() removes all of its
+/// children.  The element must be completely refilled (name, title,
+/// attributes and points) since it may have been used for a previous event.
+template <class T>
+class CP::TEveElementPool {
+public:
+    /// Make a pool for elements that are drawn as children of the parent.
+    explicit TEveElementPool(TEveElement* parent)
+        : fParent(parent), fUsed(0) {}
+
+    /// Destroy the elements held by the pool.  The parent must still exist.
+    ~TEveElementPool() {Clear();}
+
+    /// Remove the elements from the parent so they can be refilled.  The
+    /// elements are kept by the pool.
+    void Reset() {
+        fParent->RemoveElements();
+        fUsed = 0;
+    }
+
+    /// Get the next unused element and add it to the parent.  A new element
+    /// is made if all of the elements in the pool are in use.
+    T* Get() {
+        T* element = NULL;
+        if (fUsed < fElements.size()) {
+            element = fElements[fUsed];
+            element->SetRnrSelfChildren(kTRUE,kTRUE);
+            // The element is about to be refilled, so the bounding box and
+            // the GL representation must be recalculated.
+            element->ResetBBox();
+            element->StampObjProps();
+        }
+        else {
+            element = new T();
+            // Keep the element alive when it's removed from the parent.
+            element->IncDenyDestroy();
+            fElements.push_back(element);
+        }
+        ++fUsed;
+        fParent->AddElement(element);
+        return element;
+    }
+
+    /// Get the number of elements in use for the current event.
+    std::size_t GetUsed() const {return fUsed;}
+
+    /// Get the number of elements held by the pool.
+    std::size_t GetSize() const {return fElements.size();}
+
+    /// Remove the elements from the parent and destroy them.
+    void Clear() {
+        fParent->RemoveElements();
+        for (typename std::vector<T*>::iterator e = fElements.begin();
+             e != fElements.end(); ++e) {
+            (*e)->DecDenyDestroy();
+        }
+        fElements.clear();
+        fUsed = 0;
+    }
+
+private:
+
+    /// The element holding the elements from the pool.
+    TEveElement* fParent;
+
+    /// The elements in the pool.
+    std::vector<T*> fElements;
+
+    /// The number of elements in use.
+    std::size_t fUsed;
+};
+#endif
@@ -0,0 +1,88 @@
+#include "TEventCache.hxx"
+
+#include <TCaptLog.hxx>
+#include <TEvent.hxx>
+
+#include <TMutex.h>
+#include <TVirtualMutex.h>
+
+CP::TEventCache::TEventCache(long budget)
+    : fBudget(budget), fBytes(0) {
+    fMutex = new TMutex();
+}
+
+CP::TEventCache::~TEventCache() {
+    Clear();
+    delete fMutex;
+}
+
+void CP::TEventCache::Clear() {
+    TLockGuard lock(fMutex);
+    for (Elements::iterator e = fElements.begin();
+         e != fElements.end(); ++e) {
+        delete e->second.fEvent;
+    }
+    fElements.clear();
+    fUsage.clear();
+    fBytes = 0;
+}
+
+void CP::TEventCache::Insert(int entry, CP::TEvent* event, long bytes) {
+    if (!event) return;
+    if (bytes > fBudget) {
+        delete event;
+        return;
+    }
+
+    // Replace an existing copy of the entry.
+    TLockGuard lock(fMutex);
+    CP::TEvent* old = Remove(entry);
+    if (old && old != event) delete old;
+
+    fUsage.push_front(entry);
+    Element element;
+    element.fEvent = event;
+    element.fBytes = bytes;
+    element.fUsage = fUsage.begin();
+    fElements[entry] = element;
+    fBytes += bytes;
+    Evict();
+}
+
+CP::TEvent* CP::TEventCache::Take(int entry) {
+    TLockGuard lock(fMutex);
+    return Remove(entry);
+}
+
+bool CP::TEventCache::Contains(int entry) const {
+    TLockGuard lock(fMutex);
+    return fElements.find(entry) != fElements.end();
+}
+
+std::set<int> CP::TEventCache::GetEntries() const {
+    TLockGuard lock(fMutex);
+    std::set<int> entries;
+    for (Elements::const_iterator e = fElements.begin();
+         e != fElements.end(); ++e) {
+        entries.insert(e->first);
+    }
+    return entries;
+}
+
+CP::TEvent* CP::TEventCache::Remove(int entry) {
+    Elements::iterator e = fElements.find(entry);
+    if (e == fElements.end()) return NULL;
+    CP::TEvent* event = e->second.fEvent;
+    fBytes -= e->second.fBytes;
+    fUsage.erase(e->second.fUsage);
+    fElements.erase(e);
+    return event;
+}
+
+void CP::TEventCache::Evict() {
+    while (fBytes > fBudget && !fUsage.empty()) {
+        int entry = fUsage.back();
+        CaptVerbose("Evict entry " << entry << " from the event cache");
+        delete Remove(entry);
+    }
+}
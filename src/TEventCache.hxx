@@ -0,0 +1,89 @@
+#ifndef TEventCache_hxx_seen
+#define TEventCache_hxx_seen
+
+#include <list>
+#include <map>
+#include <set>
+
+namespace CP {
+    class TEventCache;
+    class TEvent;
+};
+
+class TMutex;
+
+/// A least recently used cache of events that have been displayed.  When
+/// the event display moves to a new event, the previous event is saved in
+/// the cache so that going back to it doesn't need to read the file.  The
+/// cache is limited by the total size of the events it holds, and the least
+/// recently used events are deleted when the budget is exceeded.  The cache
+/// is used by the GUI thread, but can be checked by the prefetch thread.
+class CP::TEventCache {
+public:
+    /// Create a cache that holds up to "budget" bytes of events.
+    explicit TEventCache(long budget);
+
+    /// Delete all of the events in the cache.
+    ~TEventCache();
+
+    /// Add an event to the cache (taking ownership).  The size of the event
+    /// in bytes is used to enforce the budget (see
+    /// TEventReader::GetEntryBytes()).  If the event is bigger than the
+    /// budget, it is deleted immediately.
+    void Insert(int entry, CP::TEvent* event, long bytes);
+
+    /// Remove an event from the cache and return it.  The caller takes
+    /// ownership of the event.  This returns NULL if the entry is not in the
+    /// cache.
+    CP::TEvent* Take(int entry);
+
+    /// Check if an entry is in the cache.
+    bool Contains(int entry) const;
+
+    /// Get the entries in the cache.
+    std::set<int> GetEntries() const;
+
+    /// Delete all of the events in the cache.
+    void Clear();
+
+    /// Get the total size of the events in the cache.
+    long GetBytes() const {return fBytes;}
+
+    /// Get the maximum size of the events in the cache.
+    long GetBudget() const {return fBudget;}
+
+private:
+
+    /// Remove an event from the cache and return it.  The mutex must be
+    /// held.
+    CP::TEvent* Remove(int entry);
+
+    /// Delete least recently used events until the cache is within budget.
+    /// The mutex must be held.
+    void Evict();
+
+    /// The entries in the cache, with the most recently used first.
+    typedef std::list<int> Usage;
+    Usage fUsage;
+
+    /// A cached event, its size, and its position in the usage list.
+    struct Element {
+        CP::TEvent* fEvent;
+        long fBytes;
+        Usage::iterator fUsage;
+    };
+
+    /// The cached events, keyed by entry.
+    typedef std::map<int, Element> Elements;
+    Elements fElements;
+
+    /// The maximum size of the events in the cache.
+    long fBudget;
+
+    /// The total size of the events in the cache.
+    long fBytes;
+
+    /// Protect the entries in the cache.
+    TMutex* fMutex;
+};
+#endif
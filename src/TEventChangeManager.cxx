@@ -2,6 +2,16 @@
 #include "TVEventChangeHandler.hxx"
 #include "TGUIManager.hxx"
 #include "TEventDisplay.hxx"
+#include "TEventReader.hxx"
+#include "TEventPrefetcher.hxx"
+#include "TEventIndex.hxx"
+#include "TEventCache.hxx"
+#include "TEventSearch.hxx"
+#include "TChainedInput.hxx"
+#include "TVEventPredicate.hxx"
+#include "TDisplayTimer.hxx"
+#include "TDigitIndex.hxx"
+#include "TChannelTable.hxx"
 
 #include <TEvent.hxx>
 #include <TEventFolder.hxx>
@@ -9,15 +19,62 @@
 #include <TManager.hxx>
 #include <TGeomIdManager.hxx>
 #include <TChannelInfo.hxx>
+#include <TRuntimeParameters.hxx>
+#include <TDigitContainer.hxx>
 
 #include <TQObject.h>
 #include <TGButton.h>
+#include <TGTextEntry.h>
+#include <TGListBox.h>
+#include <TList.h>
 #include <TGeoManager.h>
 #include <TGeoPgon.h>
 #include <TEveGeoShape.h>
+#include <TEveGeoShapeExtract.h>
+#include <TEveScene.h>
+#include <TFile.h>
+#include <TDirectory.h>
+#include <TNamed.h>
 #include <TEveManager.h>
+#include <TTimer.h>
+#include <TThread.h>
+#include <TMutex.h>
+#include <TVirtualMutex.h>
+#include <TDatabasePDG.h>
+#include <TSystem.h>
 
 #include <iostream>
+#include <algorithm>
+#include <string>
+#include <cstdlib>
+#include <sstream>
+#include <map>
+#include <set>
+#include <cctype>
+
+namespace {
+    /// The work of a handler being prepared in a thread.
+    struct PrepareJob {
+        CP::TVEventChangeHandler* fHandler;
+        TThread* fThread;
+        TMutex* fMutex;
+        bool fDone;
+        bool fCommitted;
+    };
+
+    /// Run the Prepare() method of a handler in a thread.
+    void* PrepareThread(void* arg) {
+        PrepareJob* job = static_cast<PrepareJob*>(arg);
+        {
+            CP::TDisplayTimer timer("prepare", job->fHandler->GetName());
+            job->fHandler->Prepare();
+        }
+        job->fMutex->Lock();
+        job->fDone = true;
+        job->fMutex->UnLock();
+        return NULL;
+    }
+};
 
 ClassImp(CP::TEventChangeManager);
 
@@ -25,8 +82,8 @@ namespace {
 
     /// This takes a geometry id and "clones" it into the Eve display.
     TEveGeoShape* GeometryClone(CP::TGeometryId id) {
-        std::cout << id << " " << id.GetName() << std::endl;
         if (!CP::TManager::Get().GeomId().CdId(id)) return NULL;
+        CaptVerbose("Clone " << id << " " << id.GetName());
 
         TGeoNode* current = gGeoManager->GetCurrentNode();
         TGeoMatrix* currMat = gGeoManager->GetCurrentMatrix();
@@ -52,44 +109,223 @@ namespace {
         return fakeShape;
     }
 
-    /// This is called when a new geometry is loaded.  The implementation is
-    /// sloppy since it assumes it's only going to be called once.  That's
-    /// actually a reasonable assumption for the usual use case, but it should
-    /// probably be fixed.  The problem is that the TEveElementList is created
-    /// everytime this class is used.
+    /// Clone the drift region and the photosensors into a simplified
+    /// geometry.  The top element has no shape and holds the clones so that
+    /// the whole tree can be saved as a shape extract.
+    TEveGeoShape* BuildSimplifiedGeometry() {
+        TEveGeoShape* simple = new TEveGeoShape("simplifiedGeometry");
+
+        // Add the drift region.
+        TEveGeoShape *shape = GeometryClone(CP::GeomId::Captain::Drift());
+        if (shape) {
+            shape->SetMainColor(kCyan);
+            shape->SetMainTransparency(80);
+            simple->AddElement(shape);
+        }
+
+        // Add the pmts.  There are up to about 24, but this has a large
+        // limit so that it catches any expansions.
+        for (int i=0; i<200; ++i) {
+            shape = GeometryClone(CP::GeomId::Captain::Photosensor(i));
+            if (!shape) break;
+            shape->SetMainColor(kYellow);
+            simple->AddElement(shape);
+        }
+
+        return simple;
+    }
+
+    /// This is called when a new geometry is loaded.  The simplified
+    /// geometry is kept for each geometry hash, so switching between files
+    /// that share a geometry reuses the scene.  The first time a geometry is
+    /// seen, the scene is also saved in the geometry cache directory so that
+    /// it doesn't need to be cloned the next time the display is started.
     class GeometryChangeCallback: public CP::TManager::GeometryChange {
     public:
+        GeometryChangeCallback() : fCurrent(NULL) {}
+
         void Callback(const CP::TEvent* const event) {
-            CaptError("New geometry loaded " << gGeoManager);
+            CaptLog("New geometry loaded " << gGeoManager);
 
             if (!CP::TEventDisplay::Get().EventChange().GetShowGeometry()) {
                 return;
             }
 
-            TEveElementList* simple = new TEveElementList("simplifiedGeometry");
+            // Take down the old geometry.  The scene stays in the cache.
+            if (fCurrent) {
+                gEve->GetGlobalScene()->RemoveElement(fCurrent);
+                fCurrent = NULL;
+            }
 
-            // Add the drift region.
-            TEveGeoShape *shape = GeometryClone(CP::GeomId::Captain::Drift());
-            shape->SetMainColor(kCyan);
-            shape->SetMainTransparency(80);
-            simple->AddElement(shape);
+            std::string key;
+            if (event) {
+                std::ostringstream hash;
+                hash << event->GetGeometryHash();
+                std::string text = hash.str();
+                for (std::string::iterator c = text.begin();
+                     c != text.end(); ++c) {
+                    if (std::isalnum((unsigned char) *c)) key += *c;
+                }
+            }
 
-            // Add the pmts.  There are up to about 24, but this has a large
-            // limit so that it catches any expansions.
-            for (int i=0; i<200; ++i) {
-                shape = GeometryClone(CP::GeomId::Captain::Photosensor(i));
-                if (!shape) break;
-                shape->SetMainColor(kYellow);
-                simple->AddElement(shape);
+            TEveGeoShape* simple = NULL;
+            std::map<std::string, TEveGeoShape*>::iterator cached
+                = fScenes.find(key);
+            if (!key.empty() && cached != fScenes.end()) {
+                CaptLog("Reuse the simplified geometry for " << key);
+                simple = cached->second;
+            }
+            if (!simple) simple = ReadScene(key);
+            if (!simple) {
+                simple = BuildSimplifiedGeometry();
+                WriteScene(key, simple);
+            }
+            if (!key.empty()) {
+                // Keep the scene when it's removed from the global scene.
+                if (fScenes.find(key) == fScenes.end()) {
+                    simple->IncDenyDestroy();
+                }
+                fScenes[key] = simple;
             }
 
             gEve->AddGlobalElement(simple);
+            fCurrent = simple;
+        }
+
+    private:
+        /// The version of the saved scenes.  It's part of the file name, so
+        /// it must be incremented when the simplified geometry changes, and
+        /// files written by older versions are then ignored.
+        enum {kSceneVersion = 1};
+
+        /// The name of the file holding the scene for a geometry hash, or
+        /// an empty string if the scene shouldn't be saved.
+        std::string SceneFileName(const std::string& key) {
+            if (key.empty()) return "";
+            std::string directory = CP::TRuntimeParameters::Get()
+                .GetParameterS("eventDisplay.geometry.cacheDirectory");
+            if (directory.empty()) return "";
+            char* expanded = gSystem->ExpandPathName(directory.c_str());
+            directory = expanded;
+            delete [] expanded;
+            std::ostringstream name;
+            name << directory << "/simplifiedGeometry-v" << kSceneVersion
+                 << "-" << key << ".root";
+            return name.str();
+        }
+
+        /// Delete an extract after it has been imported.  The imported
+        /// shapes take the TGeoShape objects, so they are removed from the
+        /// extracts before the extracts are deleted.
+        void DeleteExtract(TEveGeoShapeExtract* extract) {
+            TList* elements = extract->GetElements();
+            if (elements) {
+                TIter next(elements);
+                TEveGeoShapeExtract* child;
+                while ((child = dynamic_cast<TEveGeoShapeExtract*>(next()))) {
+                    DeleteExtract(child);
+                }
+                elements->Clear("nodelete");
+            }
+            extract->SetShape(NULL);
+            delete extract;
+        }
+
+        /// Read a scene saved by an earlier run.  This returns NULL if there
+        /// isn't one, or if it wasn't saved for the geometry hash.
+        TEveGeoShape* ReadScene(const std::string& key) {
+            std::string fileName = SceneFileName(key);
+            if (fileName.empty()) return NULL;
+            if (gSystem->AccessPathName(fileName.c_str())) return NULL;
+            TFile* file = TFile::Open(fileName.c_str(), "READ");
+            if (!file || file->IsZombie()) {
+                CaptError("Cannot read geometry cache " << fileName);
+                delete file;
+                return NULL;
+            }
+            TNamed* hash = dynamic_cast<TNamed*>(file->Get("geometryHash"));
+            TEveGeoShapeExtract* extract
+                = dynamic_cast<TEveGeoShapeExtract*>(
+                    file->Get("simplifiedGeometry"));
+            TEveGeoShape* simple = NULL;
+            if (!hash || key != hash->GetTitle()) {
+                CaptError("Geometry cache " << fileName
+                          << " is not for geometry " << key);
+            }
+            else if (!extract || !extract->HasElements()) {
+                CaptError("No simplified geometry in " << fileName);
+            }
+            else {
+                CaptLog("Read the simplified geometry from " << fileName);
+                simple = TEveGeoShape::ImportShapeExtract(extract, NULL);
+            }
+            if (extract) DeleteExtract(extract);
+            delete hash;
+            file->Close();
+            delete file;
+            return simple;
         }
+
+        /// Save a new scene so that later runs can read it.  The scene is
+        /// written to a temporary file and then renamed, so a partially
+        /// written file is never read.
+        void WriteScene(const std::string& key, TEveGeoShape* simple) {
+            std::string fileName = SceneFileName(key);
+            if (fileName.empty()) return;
+            std::string directory = gSystem->DirName(fileName.c_str());
+            gSystem->mkdir(directory.c_str(), kTRUE);
+            std::ostringstream tmpName;
+            tmpName << fileName << ".tmp" << gSystem->GetPid();
+            TDirectory* saved = gDirectory;
+            TFile* file = TFile::Open(tmpName.str().c_str(), "RECREATE");
+            if (!file || file->IsZombie()) {
+                CaptError("Cannot write geometry cache " << fileName);
+                delete file;
+                gDirectory = saved;
+                return;
+            }
+            TNamed hash("geometryHash", key.c_str());
+            hash.Write();
+            simple->WriteExtract("simplifiedGeometry");
+            file->Close();
+            delete file;
+            gDirectory = saved;
+            if (gSystem->Rename(tmpName.str().c_str(), fileName.c_str())) {
+                CaptError("Failed to save geometry cache " << fileName);
+                gSystem->Unlink(tmpName.str().c_str());
+                return;
+            }
+            CaptLog("Saved the simplified geometry to " << fileName);
+        }
+
+        /// The simplified geometry that is being shown.
+        TEveGeoShape* fCurrent;
+
+        /// The simplified geometries that have been built, keyed by the
+        /// geometry hash.
+        std::map<std::string, TEveGeoShape*> fScenes;
     };
 };
 
 
-CP::TEventChangeManager::TEventChangeManager() {
+CP::TEventChangeManager::TEventChangeManager()
+    : fEventSource(NULL), fReader(NULL), fPrefetcher(NULL),
+      fPrefetchDepth(0), fEventCache(NULL), fCurrentEntry(-1),
+      fEventSerial(0), fGeometryMutex(NULL), fSearching(false),
+      fFollowInterval(0), fFollowTimer(NULL),
+      fFollowSize(0), fFollowTime(0), fUpdating(false), fPendingEntry(-1),
+      fGeneration(0), fUpdateGeneration(0), fGenerationMutex(NULL),
+      fShowGeometry(false),
+      fDigitIndexSerial(-1) {
+    // The cache budget is set in megabytes.
+    long cacheBytes = CP::TRuntimeParameters::Get().GetParameterI(
+        "eventDisplay.cache.megabytes");
+    fEventCache = new CP::TEventCache(cacheBytes*1024*1024);
+
+    TThread::Initialize();
+    fGeometryMutex = new TMutex();
+    fGenerationMutex = new TMutex();
+
     TGButton* button = CP::TEventDisplay::Get().GUI().GetNextEventButton();
     if (button) {
         button->Connect("Clicked()",
@@ -114,12 +350,36 @@ CP::TEventChangeManager::TEventChangeManager() {
                         "ChangeEvent(=-1)");
     }
 
-    TGNumberEntry* field = CP::TEventDisplay::Get().GUI().GetEventField();
+    TGTextEntry* field = CP::TEventDisplay::Get().GUI().GetEventField();
+    if (field) {
+	field->Connect("ReturnPressed()",
+		       "CP::TEventChangeManager",
+		       this,
+		       "SelectEvent()");
+    }
+
+    field = CP::TEventDisplay::Get().GUI().GetTrajectoryFilterField();
     if (field) {
-	(field->GetNumberEntry())->Connect("ReturnPressed()",
-					   "CP::TEventChangeManager",
-					   this,
-					   "SelectEvent()");
+        field->Connect("ReturnPressed()",
+                       "CP::TEventChangeManager",
+                       this,
+                       "ChangeEvent(=0)");
+    }
+
+    button = CP::TEventDisplay::Get().GUI().GetSearchButton();
+    if (button) {
+        button->Connect("Clicked()",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "SearchEvent()");
+    }
+
+    button = CP::TEventDisplay::Get().GUI().GetPrintTimingButton();
+    if (button) {
+        button->Connect("Clicked()",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "PrintTiming()");
     }
 
     // Register a geometry change manager to handle when a new geometry
@@ -127,97 +387,405 @@ CP::TEventChangeManager::TEventChangeManager() {
     CP::TManager::Get().RegisterGeometryCallback(new GeometryChangeCallback);
 }
 
-CP::TEventChangeManager::~TEventChangeManager() {}
+CP::TEventChangeManager::~TEventChangeManager() {
+    if (fFollowTimer) delete fFollowTimer;
+    if (fPrefetcher) delete fPrefetcher;
+    if (fEventCache) delete fEventCache;
+    if (fReader) delete fReader;
+    delete fGeometryMutex;
+    delete fGenerationMutex;
+    for (std::map<std::string, CP::TDigitIndex*>::iterator i
+             = fDigitIndices.begin(); i != fDigitIndices.end(); ++i) {
+        delete i->second;
+    }
+}
 
 void CP::TEventChangeManager::SetEventSource(CP::TVInputFile* source) {
     if (!source) {
         CaptError("Invalid event source");
         return;
     }
+    fEventCache->Clear();
     fEventSource = source;
-    fEventSource->FirstEvent();
-    NewEvent();
-    UpdateEvent();
+    MakeReader();
+    fCurrentEntry = -1;
+
+    if (fFollowInterval > 0) {
+        // Following a file that is being written.  The event index would be
+        // out of date as soon as the file grows, and prefetching around the
+        // newest event is pointless, so just wait for new events.
+        CaptLog("Follow " << fEventSource->GetInputName() << " every "
+                << fFollowInterval << " ms");
+        if (!fFollowTimer) {
+            fFollowTimer = new TTimer(fFollowInterval);
+            fFollowTimer->Connect("Timeout()",
+                                  "CP::TEventChangeManager",
+                                  this,
+                                  "FollowEvent()");
+        }
+        fFollowTimer->TurnOn();
+        FollowEvent();
+        return;
+    }
+
+    // The event index is only needed to select an event by the run and
+    // event number, so it's loaded (or built) the first time that happens.
+    StartPrefetch();
+    RequestEntry(0);
+    if (fCurrentEntry < 0) CaptError("No events in the event source");
+}
+
+void CP::TEventChangeManager::MakeReader() {
+    if (fPrefetcher) delete fPrefetcher;
+    fPrefetcher = NULL;
+    if (fReader) delete fReader;
+    fReader = new CP::TEventReader(fEventSource);
+
+    // The digits are pruned from the events that are saved for later
+    // unless they are needed by a handler.  They are read again if a
+    // plotter requests them once the event is displayed.
+    fReader->AddPrunedFolder("digits");
+    for (std::vector<std::string>::iterator p = fRequiredPaths.begin();
+         p != fRequiredPaths.end(); ++p) {
+        fReader->AddRequiredPath(*p);
+    }
+}
+
+void CP::TEventChangeManager::FollowEvent() {
+    if (fSearching || fUpdating || !fEventSource) return;
+
+    // Only look at the file when it has changed.
+    std::string inputName(fEventSource->GetInputName());
+    FileStat_t stat;
+    if (gSystem->GetPathInfo(inputName.c_str(), stat) != 0) return;
+    if (stat.fSize == fFollowSize && stat.fMtime == fFollowTime) return;
+    fFollowSize = stat.fSize;
+    fFollowTime = stat.fMtime;
+
+    // The entries written after a file is opened aren't seen until the tree
+    // metadata is read again.  The tree only counts the entries saved by
+    // the writer, so the last entry is complete.  The entry numbers don't
+    // change as the file grows, so the current entry stays valid.
+    fReader->Refresh();
+    int last = fReader->GetEntryCount() - 1;
+    if (last <= fCurrentEntry) return;
+
+    // Jump straight to the newest event.  The latency is timed from when
+    // the new entry is seen until the display has been redrawn.
+    CP::TDisplayTimer latencyTimer("follow latency");
+    int skipped = last - fCurrentEntry - 1;
+    if (fCurrentEntry < 0) skipped = 0;
+    CaptLog("Follow entry " << last
+            << " (skipped " << skipped << " events)");
+    RequestEntry(last);
+
+    // Redraw3D() only schedules the redraw, so finish it now so that the
+    // latency includes it.
+    gEve->DoRedraw3D();
+}
+
+void CP::TEventChangeManager::SetPrefetchDepth(int depth) {
+    fPrefetchDepth = std::max(0,depth);
+    if (fReader) StartPrefetch();
+}
+
+void CP::TEventChangeManager::StartPrefetch() {
+    if (fPrefetcher) delete fPrefetcher;
+    fPrefetcher = NULL;
+    if (fPrefetchDepth < 1) return;
+    if (!fReader->HasDirectRead()) {
+        CaptWarn("Events can only be prefetched from a ROOT file");
+        return;
+    }
+    fPrefetcher = new CP::TEventPrefetcher(fReader, fPrefetchDepth,
+                                           fEventCache);
+    fPrefetcher->SetCenter(fCurrentEntry);
+}
+
+bool CP::TEventChangeManager::ShowEntry(int entry) {
+    CP::TDisplayTimer readTimer("read");
+    CP::TEvent* event = fEventCache->Take(entry);
+    if (!event && fPrefetcher) event = fPrefetcher->Take(entry);
+    if (!event) event = fReader->ReadEntry(entry);
+    readTimer.Stop();
+    if (!event) return false;
+
+    // Save the previous event so that going back to it doesn't touch the
+    // disk.  The bulky data is pruned before the event is saved.  The event
+    // is charged with the size of its entry in the file, so an event is
+    // only cached when it's read directly from the tree.
+    CP::TEvent* currentEvent = CP::TEventFolder::GetCurrentEvent();
+    fReader->Attach(event);
+    if (currentEvent && currentEvent != event) {
+        int bytes = -1;
+        if (fCurrentEntry >= 0) bytes = fReader->GetEntryBytes(fCurrentEntry);
+        if (bytes >= 0) {
+            fReader->PruneEvent(currentEvent, fCurrentEntry);
+            fEventCache->Insert(fCurrentEntry, currentEvent, bytes);
+        }
+        else {
+            delete currentEvent;
+        }
+    }
+    fCurrentEntry = entry;
+    ++fEventSerial;
+
+    if (fPrefetcher) fPrefetcher->SetCenter(fCurrentEntry);
+
+    // Only remember what was pruned from the events that are still held.
+    std::set<int> held = fEventCache->GetEntries();
+    held.insert(fCurrentEntry);
+    if (fPrefetcher) {
+        int depth = fPrefetcher->GetDepth();
+        for (int e = fCurrentEntry-depth; e <= fCurrentEntry+depth; ++e) {
+            held.insert(e);
+        }
+    }
+    fReader->ForgetPrunedPaths(held);
+    return true;
 }
 
 void CP::TEventChangeManager::AddNewEventHandler(
     CP::TVEventChangeHandler* handler) {
     fNewEventHandlers.push_back(handler);
+    handler->GetEventPaths(fRequiredPaths);
 }
 
 void CP::TEventChangeManager::AddUpdateHandler(
     CP::TVEventChangeHandler* handler) {
     fUpdateHandlers.push_back(handler);
+    fUpdateSerials.push_back(-1);
+    fUpdateStates.push_back("");
+    handler->GetEventPaths(fRequiredPaths);
+}
+
+void CP::TEventChangeManager::LoadEventPaths(
+    const std::vector<std::string>& paths) {
+    if (!fReader) return;
+    if (fUpdating) {
+        CaptError("Event update in progress");
+        return;
+    }
+    CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
+    if (!fReader->LoadEventPaths(event, fCurrentEntry, paths)) {
+        CaptError("Unable to load event data for entry " << fCurrentEntry);
+    }
 }
 
 void CP::TEventChangeManager::ChangeEvent(int change) {
     CaptError("Change Event by " << change << " entries");
+    if (fSearching) {
+        CaptError("Event search in progress");
+        return;
+    }
     if (!GetEventSource()) {
         CaptError("Event source is not available");
         UpdateEvent();
         return;
     }
-    CP::TEvent* currentEvent = CP::TEventFolder::GetCurrentEvent();
-    CP::TEvent* nextEvent = NULL;
-    if (change > 0) {
-        nextEvent = GetEventSource()->NextEvent(change-1);
-        if (!nextEvent) {
-            nextEvent = GetEventSource()->PreviousEvent();
-        }
-        if (nextEvent && currentEvent) delete currentEvent;
-    }
-    if (change < 0) {
-        nextEvent = GetEventSource()->PreviousEvent(change+1);
-        if (!nextEvent) nextEvent = GetEventSource()->NextEvent();
-        if (nextEvent && currentEvent) delete currentEvent;
-    }
-    currentEvent = CP::TEventFolder::GetCurrentEvent();
-    if (!currentEvent) {
-        CaptLog("No Current Event");
-        return;
-    }
 
-    if (change != 0) NewEvent(); 
+    // Changes made while an update is running are relative to the entry
+    // that is waiting to be shown.
+    int entry = fCurrentEntry;
+    if (fUpdating && fPendingEntry >= 0) entry = fPendingEntry;
+
+    if (change != 0) {
+        // Stay inside the file.  If the number of entries isn't known, then
+        // a failed read leaves the current event in place.
+        entry = std::max(0, entry + change);
+        int entries = fReader->GetEntryCount();
+        if (entries > 0) entry = std::min(entry, entries-1);
+    }
 
-    UpdateEvent();
+    RequestEntry(entry);
 }
 
 void CP::TEventChangeManager::SelectEvent() {
-    int change = 0;
-    TGNumberEntry* field = CP::TEventDisplay::Get().GUI().GetEventField();
-    if (field) {
-	change = field->GetNumberEntry()->GetIntNumber();
-    }
+    std::string selection;
+    TGTextEntry* field = CP::TEventDisplay::Get().GUI().GetEventField();
+    if (field) selection = field->GetText();
 
-    CaptError("Select Event " << change);
+    CaptError("Select Event " << selection);
+    if (fSearching) {
+        CaptError("Event search in progress");
+        return;
+    }
     if (!GetEventSource()) {
 	CaptError("Event source is not available");
 	UpdateEvent();
 	return;
     }
 
-    CP::TEvent* currentEvent = CP::TEventFolder::GetCurrentEvent();
-    CP::TEvent* nextEvent = NULL;
+    // The selection is either "run.event", or the event number in the file
+    // (counting from one).
+    int entry = -1;
+    std::size_t dot = selection.find('.');
+    if (dot != std::string::npos && fFollowInterval > 0) {
+        // The index would be out of date as soon as the file grows.
+        CaptError("Cannot select a run and event while following a file");
+    }
+    else if (dot != std::string::npos) {
+        int run = std::atoi(selection.substr(0,dot).c_str());
+        int event = std::atoi(selection.substr(dot+1).c_str());
+        entry = fReader->GetIndex().FindEntry(run,event);
+        if (entry < 0) {
+            CaptError("Event " << run << "." << event << " is not in the file");
+        }
+    }
+    else if (!selection.empty()) {
+        entry = std::atoi(selection.c_str()) - 1;
+    }
+
+    if (entry < 0) entry = fCurrentEntry;
+    RequestEntry(entry);
+}
 
-    if (change > 0) {
-	nextEvent = GetEventSource()->FirstEvent();
-	nextEvent = GetEventSource()->NextEvent(change-2);
-	if (!nextEvent) nextEvent = GetEventSource()->PreviousEvent();
-	if (nextEvent && currentEvent) delete currentEvent;
+void CP::TEventChangeManager::SearchEvent() {
+    if (fSearching) {
+        CaptError("Event search in progress");
+        return;
     }
-    currentEvent = CP::TEventFolder::GetCurrentEvent();
-    if (!currentEvent) {
-	CaptLog("No Current Event");
-	return;
+    if (fUpdating) {
+        CaptError("Event update in progress");
+        return;
+    }
+    if (!GetEventSource()) {
+        CaptError("Event source is not available");
+        return;
+    }
+
+    // The search workers read the ROOT files directly, and need to know
+    // how many entries there are.
+    int entries = fReader->GetEntryCount();
+    if (entries < 0 || !fReader->HasDirectRead()) {
+        CaptError("Search isn't available for "
+                  << GetEventSource()->GetInputName());
+        return;
+    }
+
+    std::string condition;
+    TGTextEntry* field = CP::TEventDisplay::Get().GUI().GetSearchField();
+    if (field) condition = field->GetText();
+    CP::TVEventPredicate* predicate
+        = CP::TEventSearch::MakePredicate(condition);
+    if (!predicate) {
+        CaptError("Invalid search condition: " << condition);
+        return;
     }
 
-    if (change != 0) NewEvent();
+    int last = entries - 1;
+    int threads = CP::TRuntimeParameters::Get().GetParameterI(
+        "eventDisplay.search.threads");
+
+    // A chain of files is searched one file at a time, starting with the
+    // file holding the next entry.
+    std::vector<std::string> fileNames;
+    std::vector<int> firstEntries;
+    CP::TChainedInput* chain
+        = dynamic_cast<CP::TChainedInput*>(GetEventSource());
+    if (chain) {
+        for (int i = 0; i < chain->GetFileCount(); ++i) {
+            fileNames.push_back(chain->GetFileName(i));
+            firstEntries.push_back(chain->GetFirstEntry(i));
+        }
+    }
+    else {
+        fileNames.push_back(GetEventSource()->GetInputName());
+        firstEntries.push_back(0);
+    }
+    firstEntries.push_back(last+1);
+
+    fSearching = true;
+    int entry = -1;
+    for (std::size_t i = 0; i < fileNames.size() && entry < 0; ++i) {
+        int first = std::max(fCurrentEntry+1, firstEntries[i]);
+        int end = firstEntries[i+1];
+        if (first >= end) continue;
+        CP::TEventSearch search(fileNames[i], threads);
+        int found = search.Find(*predicate,
+                                first - firstEntries[i],
+                                end - firstEntries[i] - 1);
+        if (found >= 0) entry = found + firstEntries[i];
+    }
+    fSearching = false;
+    delete predicate;
 
-    UpdateEvent();
+    if (entry < 0) {
+        CaptLog("No event after entry " << fCurrentEntry
+                << " matches: " << condition);
+        return;
+    }
+    RequestEntry(entry);
+}
+
+void CP::TEventChangeManager::RequestEntry(int entry) {
+    if (fUpdating) {
+        // An update is running, so replace any request that is waiting, and
+        // cancel the running update.  The request is handled as soon as the
+        // running update returns.
+        fPendingEntry = entry;
+        TLockGuard lock(fGenerationMutex);
+        ++fGeneration;
+        return;
+    }
+
+    fUpdating = true;
+    while (entry >= 0) {
+        fPendingEntry = -1;
+        {
+            TLockGuard lock(fGenerationMutex);
+            ++fGeneration;
+        }
+        if (entry != fCurrentEntry) {
+            if (ShowEntry(entry)) NewEvent();
+            else CaptError("Entry " << entry << " is not available");
+        }
+        UpdateEvent();
+        entry = fPendingEntry;
+    }
+    fUpdating = false;
+}
+
+const CP::TDigitIndex*
+CP::TEventChangeManager::GetDigitIndex(const std::string& path) {
+    // The indices belong to the event they were built for.
+    if (fDigitIndexSerial != fEventSerial) {
+        for (std::map<std::string, CP::TDigitIndex*>::iterator i
+                 = fDigitIndices.begin(); i != fDigitIndices.end(); ++i) {
+            delete i->second;
+        }
+        fDigitIndices.clear();
+        fDigitIndexSerial = fEventSerial;
+    }
+
+    std::map<std::string, CP::TDigitIndex*>::iterator found
+        = fDigitIndices.find(path);
+    if (found != fDigitIndices.end()) return found->second;
+
+    CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
+    if (!event) return NULL;
+    CP::THandle<CP::TDigitContainer> digits
+        = event->Get<CP::TDigitContainer>(path.c_str());
+    if (!digits) return NULL;
+
+    CP::TDisplayTimer timer("digit index");
+    CP::TDigitIndex* index = new CP::TDigitIndex(*digits);
+    fDigitIndices[path] = index;
+    return index;
+}
+
+bool CP::TEventChangeManager::IsUpdateCancelled() const {
+    TLockGuard lock(fGenerationMutex);
+    return fGeneration != fUpdateGeneration;
+}
+
+void CP::TEventChangeManager::PrintTiming() {
+    CP::TDisplayTimer::PrintReport(std::cout);
 }
 
 void CP::TEventChangeManager::NewEvent() {
     CaptError("New Event");
+    CP::TDisplayTimer timer("NewEvent");
 
     CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
     if (!event) {
@@ -233,6 +801,7 @@ void CP::TEventChangeManager::NewEvent() {
     // Run through all of the handlers.
     for (Handlers::iterator h = fNewEventHandlers.begin();
          h != fNewEventHandlers.end(); ++h) {
+        CP::TDisplayTimer handlerTimer("apply", (*h)->GetName());
         (*h)->Apply();
     }
 
@@ -246,15 +815,159 @@ void CP::TEventChangeManager::UpdateEvent() {
         return;
     }
 
-    // Make sure that the event geometry is updated.
+    // Make sure that the event geometry is updated.  The channel table
+    // finds the wires in the geometry, so it's set after the geometry is
+    // loaded, and is only rebuilt when the calibrations or the geometry
+    // might change.
     CP::TManager::Get().Geometry();
+    CP::TChannelTable::Get().SetEvent(*event);
     
-    // Run through all of the handlers.
-    for (Handlers::iterator h = fUpdateHandlers.begin();
-         h != fUpdateHandlers.end(); ++h) {
-        (*h)->Apply();
+    // Only rerun the handlers that haven't seen this event, or that have
+    // controls that changed since they were last run.
+    std::vector<int> dirty;
+    for (std::size_t i = 0; i < fUpdateHandlers.size(); ++i) {
+        std::vector<TGFrame*> controls;
+        fUpdateHandlers[i]->GetControls(controls);
+        std::string state = ControlState(controls);
+        if (fUpdateSerials[i] == fEventSerial
+            && fUpdateStates[i] == state) continue;
+        dirty.push_back(i);
+        fUpdateSerials[i] = fEventSerial;
+        fUpdateStates[i] = state;
+    }
+    CaptLog("Update " << dirty.size() << " of " << fUpdateHandlers.size()
+            << " handlers");
+
+    {
+        TLockGuard lock(fGenerationMutex);
+        fUpdateGeneration = fGeneration;
+    }
+    if (!UpdateHandlers(dirty)) {
+        // A newer request arrived, so the redraw would be stale.
+        CaptLog("Update cancelled");
+        return;
     }
 
     // Make sure EVE is up to date.
+    CP::TDisplayTimer redrawTimer("redraw");
     gEve->Redraw3D(kTRUE);
 }
+
+bool CP::TEventChangeManager::UpdateHandlers(const std::vector<int>& dirty) {
+    // The particle table is filled the first time it's used, so make sure
+    // that happens before the handlers use it in parallel.
+    TDatabasePDG::Instance()->GetParticle(11);
+
+    // Compute the display data for all of the handlers at once.
+    CP::TDisplayTimer prepareTimer("prepare all");
+    TMutex jobMutex;
+    std::vector<PrepareJob> jobs(dirty.size());
+    for (std::size_t i = 0; i < dirty.size(); ++i) {
+        jobs[i].fHandler = fUpdateHandlers[dirty[i]];
+        jobs[i].fThread = NULL;
+        jobs[i].fMutex = &jobMutex;
+        jobs[i].fDone = !jobs[i].fHandler->HasPrepare();
+        jobs[i].fCommitted = false;
+    }
+
+    // The event isn't thread safe, so the handlers find their event data
+    // here before the threads are started.  Only the handlers with a
+    // Prepare() step get a thread.
+    for (std::vector<PrepareJob>::iterator j = jobs.begin();
+         j != jobs.end(); ++j) {
+        if (j->fDone) continue;
+        j->fHandler->Resolve();
+        j->fThread = new TThread("prepareHandler", &PrepareThread, &(*j));
+        j->fThread->Run();
+    }
+
+    // Wait for the handlers while keeping the GUI alive so that a newer
+    // request can cancel this update.  The slots that read the event refuse
+    // to run while the update is running (see IsUpdating()).  The coarse
+    // handlers are committed as soon as they are prepared so that they are
+    // shown first, but the handlers without a Prepare() step read the event
+    // when they are committed, so they wait until the threads are finished.
+    bool cancelled = false;
+    while (true) {
+        int running = 0;
+        bool committed = false;
+        for (std::vector<PrepareJob>::iterator j = jobs.begin();
+             j != jobs.end(); ++j) {
+            jobMutex.Lock();
+            bool done = j->fDone;
+            jobMutex.UnLock();
+            if (!done) {
+                ++running;
+                continue;
+            }
+            if (cancelled || j->fCommitted || !j->fThread) continue;
+            if (j->fHandler->GetDetailLevel() > 0) continue;
+            CP::TDisplayTimer handlerTimer("commit", j->fHandler->GetName());
+            j->fHandler->Commit();
+            j->fCommitted = true;
+            committed = true;
+        }
+        if (committed && running > 0) gEve->Redraw3D(kFALSE);
+        if (running < 1) break;
+        gSystem->ProcessEvents();
+        if (IsUpdateCancelled()) cancelled = true;
+        gSystem->Sleep(2);
+    }
+    for (std::vector<PrepareJob>::iterator j = jobs.begin();
+         j != jobs.end(); ++j) {
+        if (!j->fThread) continue;
+        j->fThread->Join();
+        delete j->fThread;
+    }
+    prepareTimer.Stop();
+
+    // Fill in the detailed handlers, and the handlers that weren't
+    // prepared in a thread.
+    for (std::vector<PrepareJob>::iterator j = jobs.begin();
+         j != jobs.end() && !cancelled; ++j) {
+        if (j->fCommitted) continue;
+        CP::TDisplayTimer handlerTimer("commit", j->fHandler->GetName());
+        j->fHandler->Commit();
+        j->fCommitted = true;
+        if (IsUpdateCancelled()) cancelled = true;
+    }
+
+    // The handlers that weren't committed need to be run again.
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+        if (!jobs[i].fCommitted) fUpdateSerials[dirty[i]] = -1;
+    }
+
+    return !cancelled;
+}
+
+std::string CP::TEventChangeManager::ControlState(
+    const std::vector<TGFrame*>& controls) {
+    std::ostringstream state;
+    for (std::vector<TGFrame*>::const_iterator c = controls.begin();
+         c != controls.end(); ++c) {
+        state << "|";
+        TGButton* button = dynamic_cast<TGButton*>(*c);
+        if (button) {
+            state << button->GetState();
+            continue;
+        }
+        TGTextEntry* text = dynamic_cast<TGTextEntry*>(*c);
+        if (text) {
+            state << text->GetText();
+            continue;
+        }
+        TGListBox* list = dynamic_cast<TGListBox*>(*c);
+        if (list) {
+            // The selected entries.
+            TList selected;
+            list->GetSelectedEntries(&selected);
+            TIter next(&selected);
+            TGLBEntry* entry;
+            while ((entry = (TGLBEntry*) next())) {
+                state << entry->EntryId() << ",";
+            }
+            continue;
+        }
+    }
+    return state.str();
+}
@@ -4,12 +4,23 @@
 
 #include <TObject.h>
 
+#include <vector>
+#include <string>
+#include <map>
+
 namespace CP {
     class TEventChangeManager;
+    class TDigitIndex;
     class TVEventChangeHandler;
-
+    class TEventReader;
+    class TEventPrefetcher;
+    class TEventCache;
 };
 
+class TTimer;
+class TMutex;
+class TGFrame;
+
 /// A class to handle a new event becoming available to the event display.
 /// There is a single instance of this class owned by TEventDisplay.  This
 /// must be created after the GUI has been initialized.
@@ -19,7 +30,9 @@ public:
     virtual ~TEventChangeManager();
 
     /// Set or get the event source.  When the event source is set, the first
-    /// event is read.  @{
+    /// event is read.  The event source is not owned by the manager.  When
+    /// following a file, the event source is replaced by a fresh copy of the
+    /// input file (owned by the manager) each time new events are found.  @{
     void SetEventSource(TVInputFile* source);
     TVInputFile* GetEventSource() {return fEventSource;}
     /// @}
@@ -34,6 +47,11 @@ public:
     /// when the return key is pressed.
     void SelectEvent();
 
+    /// Search forward from the current event for the next event matching
+    /// the condition in the GUI search field, and show it.  This is connected
+    /// to the "Find Next" button.
+    void SearchEvent();
+
     /// Add a handler (taking ownership of the handler) for when the event
     /// changes (e.g. a new event is read).  These handlers are for
     /// "once-per-event" actions and are executed by the NewEvent() method.
@@ -44,6 +62,65 @@ public:
     /// method.
     void AddUpdateHandler(CP::TVEventChangeHandler* handler);
     
+    /// Make sure that the event data at the paths (e.g. "~/digits/drift") is
+    /// in the current event.  The bulky folders (e.g. "digits") are pruned
+    /// from the prefetched and cached events, so this must be called by
+    /// anything that uses them (e.g. the digit plotters) before getting the
+    /// data.  If the data was pruned, the entry is read again.
+    void LoadEventPaths(const std::vector<std::string>& paths);
+
+    /// Get the index of the digits in a container of the current event
+    /// (e.g. "~/digits/drift").  The index is built the first time it's
+    /// requested for an event, and is then shared by all of the plotters.
+    /// This returns NULL if the container isn't in the event.
+    const CP::TDigitIndex* GetDigitIndex(const std::string& path);
+
+    /// Set the number of events to read ahead of (and behind) the current
+    /// event in a background thread.  If the depth is zero, then events are
+    /// read when they are needed.  Events are only prefetched from ROOT
+    /// files (see TEventReader::HasDirectRead()).
+    void SetPrefetchDepth(int depth);
+    int GetPrefetchDepth() const {return fPrefetchDepth;}
+
+    /// Print the timing report for the event display.  This is connected
+    /// to the "Print Timing" button.
+    void PrintTiming();
+
+    /// Set the interval (in milliseconds) between checks for new events in a
+    /// file that is still being written.  When the interval is positive, the
+    /// display follows the file and shows the newest event.  Events can't be
+    /// selected by the run and event number while a file is followed.  This
+    /// must be set before the event source.
+    void SetFollowInterval(int interval) {fFollowInterval = interval;}
+    int GetFollowInterval() const {return fFollowInterval;}
+
+    /// Check if new events have been written to the event source, and show
+    /// the newest one.  Intermediate events are skipped.  This is connected
+    /// to the follow timer.
+    void FollowEvent();
+
+    /// Get the mutex that must be held while navigating the geometry.  The
+    /// ROOT geometry navigator isn't thread safe, and the handlers prepare
+    /// the event in parallel.
+    TMutex* GetGeometryMutex() {return fGeometryMutex;}
+
+    /// Check if an update is running.  The handlers are being prepared or
+    /// committed, so their display data must not be touched.  The GUI is
+    /// kept alive during an update, and the threads preparing the handlers
+    /// are reading the event, so the slots that read the event or navigate
+    /// the geometry (e.g. the plots) must do nothing while this is true.
+    bool IsUpdating() const {return fUpdating;}
+
+    /// Check if the running update has been superseded by a newer request.
+    /// The handlers can check this from Prepare() to stop early since the
+    /// result will be thrown away.  This is safe to call from any thread.
+    bool IsUpdateCancelled() const;
+
+    /// Get the serial number of the current event.  This changes every time
+    /// a different event is shown, so the handlers can use it to tell if
+    /// what they have drawn belongs to the current event.
+    int GetEventSerial() const {return fEventSerial;}
+
     /// Set the flag to show (or not show) the geometry
     void SetShowGeometry(bool f) {fShowGeometry = f;}
     bool GetShowGeometry() const {return fShowGeometry;}
@@ -59,9 +136,52 @@ private:
     /// handlers.
     void UpdateEvent();
 
+    /// Make an entry in the event source the current event.  The previous
+    /// event is saved in the event cache.  This returns false if the entry
+    /// can't be read, and the current event is unchanged.
+    bool ShowEntry(int entry);
+
+    /// Start (or stop) the prefetch thread based on the prefetch depth.
+    void StartPrefetch();
+
+    /// Create the reader for the event source.
+    void MakeReader();
+
+    /// Show an entry and update the display.  If an update is already
+    /// running, the running update is cancelled and the entry is shown when
+    /// it returns.  Only the newest request is kept while waiting.
+    void RequestEntry(int entry);
+
+    /// Run the Prepare() method of the dirty update handlers (indices into
+    /// fUpdateHandlers) in parallel threads, and commit them.  Each handler
+    /// with a Prepare() step is resolved on the GUI thread before its thread
+    /// is started.  The coarse handlers are committed as soon as they are
+    /// prepared, and the detailed handlers are committed last.  This returns
+    /// false if the update was cancelled.
+    bool UpdateHandlers(const std::vector<int>& dirty);
+
+    /// Summarize the state of a set of GUI controls as a string.  The
+    /// summary changes when the state of any of the controls changes.
+    static std::string ControlState(const std::vector<TGFrame*>& controls);
+
     /// The input source of events.
     TVInputFile* fEventSource;
 
+    /// The entry based access to the event source.
+    TEventReader* fReader;
+
+    /// The background reader (if prefetching is enabled).
+    TEventPrefetcher* fPrefetcher;
+
+    /// The number of events to prefetch on each side of the current event.
+    int fPrefetchDepth;
+
+    /// The recently displayed events.
+    TEventCache* fEventCache;
+
+    /// The entry of the current event in the event source.
+    int fCurrentEntry;
+
     typedef std::vector<CP::TVEventChangeHandler*> Handlers;
 
     /// The event update handlers.
@@ -70,9 +190,67 @@ private:
     /// The new event handlers.
     Handlers fNewEventHandlers;
 
+    /// A serial number for the current event.  This changes every time a
+    /// different event is shown.
+    int fEventSerial;
+
+    /// The event serial number when each update handler was last run.
+    std::vector<int> fUpdateSerials;
+
+    /// The state of the controls of each update handler when it was last
+    /// run.
+    std::vector<std::string> fUpdateStates;
+
+    /// The event paths declared by the handlers.  These are always loaded.
+    std::vector<std::string> fRequiredPaths;
+
+    /// Serialize access to the geometry navigator.
+    TMutex* fGeometryMutex;
+
+    /// Flag that a search is running.  The GUI is kept alive during a
+    /// search, so this prevents the event from being changed under it.
+    bool fSearching;
+
+    /// The interval between checks for new events in follow mode, or zero
+    /// if the file isn't being followed.
+    int fFollowInterval;
+
+    /// The timer for follow mode.
+    TTimer* fFollowTimer;
+
+    /// The size and modification time of the followed file when it was last
+    /// checked.
+    Long64_t fFollowSize;
+    Long_t fFollowTime;
+
+    /// Flag that an update is running.  The GUI is kept alive during an
+    /// update, so new requests are queued in fPendingEntry.
+    bool fUpdating;
+
+    /// The entry requested while an update was running, or -1.
+    int fPendingEntry;
+
+    /// A counter that changes with every request.  It's read by the threads
+    /// preparing the handlers, so it's only used while holding
+    /// fGenerationMutex.
+    int fGeneration;
+
+    /// The value of fGeneration when the running update started.
+    int fUpdateGeneration;
+
+    /// Serialize access to fGeneration and fUpdateGeneration.
+    TMutex* fGenerationMutex;
+
     /// Flag to determine if the geometry will be drawn.
     bool fShowGeometry;
 
+    /// The digit indices for the current event, keyed by the path of the
+    /// digit container.
+    std::map<std::string, CP::TDigitIndex*> fDigitIndices;
+
+    /// The event serial number that the digit indices were built for.
+    int fDigitIndexSerial;
+
     ClassDef(TEventChangeManager,0);
 };
 
@@ -0,0 +1,232 @@
+#include "TEventIndex.hxx"
+#include "TEventTree.hxx"
+
+#include <TCaptLog.hxx>
+
+#include <TSystem.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    /// The identifier at the start of a sidecar file.
+    const char gSidecarMagic[8] = {'C','P','E','V','I','D','X','\0'};
+
+    /// The sidecar format version.  Increment this when the layout of the
+    /// header, record or key changes.
+    const Int_t gSidecarVersion = 1;
+
+    /// The header of the sidecar file.  The header is followed by the
+    /// records for each entry, and then by the sorted keys.
+    struct SidecarHeader {
+        char fMagic[8];
+        Int_t fVersion;
+        Int_t fEntries;
+        Long64_t fFileSize;
+        Long64_t fFileTime;
+    };
+
+    bool KeyLess(const CP::TEventIndex::Key& lhs,
+                 const CP::TEventIndex::Key& rhs) {
+        if (lhs.fRun != rhs.fRun) return lhs.fRun < rhs.fRun;
+        if (lhs.fEvent != rhs.fEvent) return lhs.fEvent < rhs.fEvent;
+        return lhs.fEntry < rhs.fEntry;
+    }
+
+    /// Get the size and modification time of the input file.
+    bool InputFileStat(const std::string& inputName,
+                       Long64_t& size, Long64_t& time) {
+        FileStat_t stat;
+        if (gSystem->GetPathInfo(inputName.c_str(), stat) != 0) return false;
+        size = stat.fSize;
+        time = stat.fMtime;
+        return true;
+    }
+};
+
+CP::TEventIndex::TEventIndex()
+    : fRecordData(NULL), fKeyData(NULL), fEntryCount(0),
+      fMapAddress(NULL), fMapLength(0) {}
+
+CP::TEventIndex::~TEventIndex() {
+    Unmap();
+}
+
+void CP::TEventIndex::Unmap() {
+    if (fMapAddress) munmap(fMapAddress, fMapLength);
+    fMapAddress = NULL;
+    fMapLength = 0;
+}
+
+void CP::TEventIndex::Clear() {
+    Unmap();
+    fRecords.clear();
+    fKeys.clear();
+    fRecordData = NULL;
+    fKeyData = NULL;
+    fEntryCount = 0;
+}
+
+void CP::TEventIndex::AddEntry(int run, int event, int bytes) {
+    Record record;
+    record.fRun = run;
+    record.fEvent = event;
+    record.fBytes = bytes;
+    fRecords.push_back(record);
+}
+
+void CP::TEventIndex::Append(const CP::TEventIndex& other) {
+    fRecords.reserve(fRecords.size() + other.GetEntryCount());
+    for (int i = 0; i < other.GetEntryCount(); ++i) {
+        fRecords.push_back(other.fRecordData[i]);
+    }
+}
+
+void CP::TEventIndex::Finalize() {
+    fKeys.clear();
+    fKeys.reserve(fRecords.size());
+    for (std::size_t i = 0; i < fRecords.size(); ++i) {
+        Key key;
+        key.fRun = fRecords[i].fRun;
+        key.fEvent = fRecords[i].fEvent;
+        key.fEntry = i;
+        fKeys.push_back(key);
+    }
+    std::sort(fKeys.begin(), fKeys.end(), KeyLess);
+    fEntryCount = fRecords.size();
+    fRecordData = fRecords.empty() ? NULL : &fRecords[0];
+    fKeyData = fKeys.empty() ? NULL : &fKeys[0];
+}
+
+int CP::TEventIndex::FindEntry(int run, int event) const {
+    if (fEntryCount < 1) return -1;
+    Key key;
+    key.fRun = run;
+    key.fEvent = event;
+    key.fEntry = -1;
+    const Key* end = fKeyData + fEntryCount;
+    const Key* found = std::lower_bound(fKeyData, end, key, KeyLess);
+    // If an event is duplicated, this finds the first entry.
+    if (found == end) return -1;
+    if (found->fRun != run || found->fEvent != event) return -1;
+    return found->fEntry;
+}
+
+bool CP::TEventIndex::Build(CP::TEventTree& tree) {
+    Clear();
+    int entries = tree.GetEntryCount();
+    CaptLog("Build the event index for " << entries << " entries");
+    for (int entry = 0; entry < entries; ++entry) {
+        int run = -1;
+        int event = -1;
+        if (!tree.ReadContext(entry, run, event)) {
+            CaptError("Cannot read the context of entry " << entry);
+            break;
+        }
+        AddEntry(run, event, tree.GetEntryBytes(entry));
+    }
+    Finalize();
+    CaptLog("Event index has " << GetEntryCount() << " entries");
+    return GetEntryCount() == entries;
+}
+
+std::string CP::TEventIndex::SidecarName(const std::string& inputName) {
+    return inputName + ".index";
+}
+
+bool CP::TEventIndex::Save(const std::string& inputName) const {
+    SidecarHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.fMagic, gSidecarMagic, sizeof(header.fMagic));
+    header.fVersion = gSidecarVersion;
+    header.fEntries = fEntryCount;
+    if (!InputFileStat(inputName, header.fFileSize, header.fFileTime)) {
+        return false;
+    }
+
+    // Write to a temporary file and then rename it so that a partially
+    // written sidecar is never seen.  The temporary name is unique to the
+    // process so that two displays opening the same file don't collide.
+    std::string sidecarName = SidecarName(inputName);
+    std::ostringstream tmpStream;
+    tmpStream << sidecarName << ".tmp" << gSystem->GetPid();
+    std::string tmpName = tmpStream.str();
+    std::ofstream output(tmpName.c_str(), std::ios::binary | std::ios::trunc);
+    if (!output) {
+        CaptLog("Cannot write event index to " << sidecarName);
+        return false;
+    }
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char*>(fRecordData),
+                 fEntryCount*sizeof(Record));
+    output.write(reinterpret_cast<const char*>(fKeyData),
+                 fEntryCount*sizeof(Key));
+    output.close();
+    if (!output || std::rename(tmpName.c_str(), sidecarName.c_str()) != 0) {
+        CaptLog("Failed to write event index to " << sidecarName);
+        std::remove(tmpName.c_str());
+        return false;
+    }
+    CaptLog("Event index saved to " << sidecarName);
+    return true;
+}
+
+bool CP::TEventIndex::Load(const std::string& inputName) {
+    Clear();
+
+    Long64_t fileSize = 0;
+    Long64_t fileTime = 0;
+    if (!InputFileStat(inputName, fileSize, fileTime)) return false;
+
+    std::string sidecarName = SidecarName(inputName);
+    int fd = open(sidecarName.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat sidecarStat;
+    if (fstat(fd, &sidecarStat) != 0
+        || sidecarStat.st_size < (off_t) sizeof(SidecarHeader)) {
+        close(fd);
+        return false;
+    }
+    std::size_t length = sidecarStat.st_size;
+    void* address = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) return false;
+    fMapAddress = address;
+    fMapLength = length;
+
+    const SidecarHeader* header
+        = static_cast<const SidecarHeader*>(fMapAddress);
+    std::size_t expected = sizeof(SidecarHeader)
+        + header->fEntries*(sizeof(Record) + sizeof(Key));
+    if (std::memcmp(header->fMagic, gSidecarMagic, sizeof(gSidecarMagic))
+        || header->fVersion != gSidecarVersion
+        || header->fEntries < 0
+        || length != expected) {
+        CaptLog("Ignoring invalid event index " << sidecarName);
+        Clear();
+        return false;
+    }
+    if (header->fFileSize != fileSize || header->fFileTime != fileTime) {
+        CaptLog("Event index " << sidecarName << " is out of date");
+        Clear();
+        return false;
+    }
+
+    const char* base = static_cast<const char*>(fMapAddress);
+    fEntryCount = header->fEntries;
+    fRecordData = reinterpret_cast<const Record*>(
+        base + sizeof(SidecarHeader));
+    fKeyData = reinterpret_cast<const Key*>(
+        base + sizeof(SidecarHeader) + fEntryCount*sizeof(Record));
+    CaptLog("Event index with " << fEntryCount << " entries read from "
+            << sidecarName);
+    return true;
+}
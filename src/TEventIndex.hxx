@@ -0,0 +1,125 @@
+#ifndef TEventIndex_hxx_seen
+#define TEventIndex_hxx_seen
+
+#include <Rtypes.h>
+
+#include <vector>
+#include <string>
+
+namespace CP {
+    class TEventIndex;
+    class TEventTree;
+};
+
+/// An index of the events in an input file.  The index maps the entry
+/// number of each event in the file to the run and event number from the
+/// event context (and the size of the event), and maps the run and event
+/// number back to the entry.  The entry can then be read directly with
+/// TEventReader::ReadEntry().
+///
+/// Building the index is a pass over the file, so the index is saved
+/// to a sidecar file next to the input file (the input file name with
+/// ".index" appended).  The sidecar records the size and modification time
+/// of the input file, and is ignored if the input file has changed.  A valid
+/// sidecar is memory mapped and used directly.
+class CP::TEventIndex {
+public:
+    TEventIndex();
+    ~TEventIndex();
+
+    /// Build the index from the tree of events in a file.  Only the event
+    /// context of each entry is read (see TEventTree::ReadContext()), and
+    /// the size comes from the baskets of the tree.  The index stops at the
+    /// first entry that can't be read, and this returns false if the index
+    /// doesn't cover every entry in the tree.  An incomplete index must not
+    /// be saved.
+    bool Build(CP::TEventTree& tree);
+
+    /// Load the index from the sidecar file for an input file.  This
+    /// returns false if the sidecar doesn't exist, or doesn't match the
+    /// input file.
+    bool Load(const std::string& inputName);
+
+    /// Save the index to the sidecar file for an input file.  This returns
+    /// false if the sidecar can't be written.
+    bool Save(const std::string& inputName) const;
+
+    /// Remove all of the entries from the index.
+    void Clear();
+
+    /// Add the next entry to the index.  The entries must be added in order,
+    /// and Finalize() must be called after the last entry is added.
+    void AddEntry(int run, int event, int bytes);
+
+    /// Add all of the entries from another index after the entries already
+    /// added.  This is used to merge the indices of chained input files, and
+    /// Finalize() must be called after the last index is appended.
+    void Append(const CP::TEventIndex& other);
+
+    /// Finish building the index after all of the entries are added.
+    void Finalize();
+
+    /// Get the number of entries in the index.
+    int GetEntryCount() const {return fEntryCount;}
+
+    /// Get the run number for an entry.
+    int GetRun(int entry) const {return fRecordData[entry].fRun;}
+
+    /// Get the event number for an entry.
+    int GetEvent(int entry) const {return fRecordData[entry].fEvent;}
+
+    /// Get the size of an entry in bytes.  This is the size of the entry in
+    /// the file (see TEventTree::GetEntryBytes()).
+    int GetBytes(int entry) const {return fRecordData[entry].fBytes;}
+
+    /// Find the entry for a run and event number.  This returns -1 if the
+    /// event isn't in the index.
+    int FindEntry(int run, int event) const;
+
+    /// Get the name of the sidecar file for an input file.
+    static std::string SidecarName(const std::string& inputName);
+
+    /// The information saved for each entry.
+    struct Record {
+        Int_t fRun;
+        Int_t fEvent;
+        Int_t fBytes;
+    };
+
+    /// The lookup key used to find an entry from the run and event.  The
+    /// keys are sorted by run and event.
+    struct Key {
+        Int_t fRun;
+        Int_t fEvent;
+        Int_t fEntry;
+    };
+
+private:
+
+    /// Release the memory mapped sidecar (if any).
+    void Unmap();
+
+    /// The records for each entry when the index is built in memory.
+    std::vector<Record> fRecords;
+
+    /// The sorted keys when the index is built in memory.
+    std::vector<Key> fKeys;
+
+    /// The records being used.  This points to either fRecords, or into the
+    /// memory mapped sidecar.
+    const Record* fRecordData;
+
+    /// The keys being used.  This points to either fKeys, or into the memory
+    /// mapped sidecar.
+    const Key* fKeyData;
+
+    /// The number of entries in the index.
+    int fEntryCount;
+
+    /// The memory mapped sidecar file (NULL if not mapped).
+    void* fMapAddress;
+
+    /// The length of the memory mapped sidecar file.
+    std::size_t fMapLength;
+};
+#endif
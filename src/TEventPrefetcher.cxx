@@ -0,0 +1,140 @@
+#include "TEventPrefetcher.hxx"
+#include "TEventReader.hxx"
+#include "TEventTree.hxx"
+#include "TEventCache.hxx"
+
+#include <TCaptLog.hxx>
+#include <TEvent.hxx>
+
+#include <TThread.h>
+#include <TMutex.h>
+#include <TCondition.h>
+
+#include <cstdlib>
+
+CP::TEventPrefetcher::TEventPrefetcher(CP::TEventReader* reader, int depth,
+                                       const CP::TEventCache* cache)
+    : fReader(reader), fCache(cache), fDepth(depth), fCenter(-1), fReading(-1),
+      fEndEntry(-1), fStop(false) {
+    int entries = fReader->GetEntryCount();
+    if (entries >= 0) fEndEntry = entries;
+
+    CP::TEventTree::EnableThreads();
+    fMutex = new TMutex();
+    fCondition = new TCondition(fMutex);
+    fThread = new TThread("eventPrefetcher",
+                          &CP::TEventPrefetcher::ThreadFunction,
+                          this);
+    fThread->Run();
+    CaptLog("Prefetching " << fDepth << " events around the current event");
+}
+
+CP::TEventPrefetcher::~TEventPrefetcher() {
+    fMutex->Lock();
+    fStop = true;
+    fCondition->Broadcast();
+    fMutex->UnLock();
+    fThread->Join();
+    delete fThread;
+
+    for (Ring::iterator r = fRing.begin(); r != fRing.end(); ++r) {
+        delete r->second;
+    }
+    fRing.clear();
+
+    delete fCondition;
+    delete fMutex;
+}
+
+void CP::TEventPrefetcher::SetCenter(int entry) {
+    fMutex->Lock();
+    fCenter = entry;
+    TrimRing();
+    fCondition->Broadcast();
+    fMutex->UnLock();
+}
+
+CP::TEvent* CP::TEventPrefetcher::Take(int entry) {
+    CP::TEvent* event = NULL;
+    fMutex->Lock();
+    while (fReading == entry) fCondition->Wait();
+    Ring::iterator r = fRing.find(entry);
+    if (r != fRing.end()) {
+        event = r->second;
+        fRing.erase(r);
+    }
+    fMutex->UnLock();
+    return event;
+}
+
+void* CP::TEventPrefetcher::ThreadFunction(void* self) {
+    static_cast<CP::TEventPrefetcher*>(self)->Run();
+    return NULL;
+}
+
+void CP::TEventPrefetcher::Run() {
+    fMutex->Lock();
+    while (!fStop) {
+        int entry = NextMissingEntry();
+        if (entry < 0) {
+            fCondition->Wait();
+            continue;
+        }
+
+        // Read the event without holding the lock so that the GUI thread
+        // can take events that are already in the ring.
+        fReading = entry;
+        fMutex->UnLock();
+        CP::TEvent* event = fReader->ReadEntry(entry);
+        fReader->PruneEvent(event, entry);
+        fMutex->Lock();
+        fReading = -1;
+
+        if (!event && entry > fCenter
+            && (fEndEntry < 0 || entry < fEndEntry)) {
+            fEndEntry = entry;
+        }
+
+        // The center may have moved while the event was being read.  A
+        // failed read is saved as a NULL so that it isn't retried.
+        if (entry != fCenter && std::abs(entry-fCenter) <= fDepth) {
+            fRing[entry] = event;
+        }
+        else {
+            delete event;
+        }
+        fCondition->Broadcast();
+    }
+    fMutex->UnLock();
+}
+
+int CP::TEventPrefetcher::NextMissingEntry() {
+    if (fCenter < 0) return -1;
+    for (int d = 1; d <= fDepth; ++d) {
+        int entry = fCenter + d;
+        if ((fEndEntry < 0 || entry < fEndEntry) && IsMissing(entry)) {
+            return entry;
+        }
+        entry = fCenter - d;
+        if (entry >= 0 && IsMissing(entry)) return entry;
+    }
+    return -1;
+}
+
+bool CP::TEventPrefetcher::IsMissing(int entry) const {
+    if (fRing.find(entry) != fRing.end()) return false;
+    if (fCache && fCache->Contains(entry)) return false;
+    return true;
+}
+
+void CP::TEventPrefetcher::TrimRing() {
+    Ring::iterator r = fRing.begin();
+    while (r != fRing.end()) {
+        if (r->first != fCenter && std::abs(r->first-fCenter) <= fDepth) {
+            ++r;
+            continue;
+        }
+        delete r->second;
+        fRing.erase(r++);
+    }
+}
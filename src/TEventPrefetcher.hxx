@@ -0,0 +1,105 @@
+#ifndef TEventPrefetcher_hxx_seen
+#define TEventPrefetcher_hxx_seen
+
+#include <map>
+
+namespace CP {
+    class TEventPrefetcher;
+    class TEventReader;
+    class TEventCache;
+    class TEvent;
+};
+
+class TThread;
+class TMutex;
+class TCondition;
+
+/// Read events in a background thread so that they are already decoded when
+/// the event display asks for them.  The prefetcher keeps a bounded ring of
+/// events around the "center" entry (the entry being displayed).  The ring
+/// extends "depth" entries ahead of, and behind the center.  The entries
+/// closest to the center are read first, and entries that fall out of the
+/// ring when the center moves are deleted.  Entries that are already in the
+/// event cache are not read again.  The events in the ring are pruned (see
+/// TEventReader::PruneEvent()).
+class CP::TEventPrefetcher {
+public:
+    /// Create a prefetcher reading from the reader and start the reader
+    /// thread.  The entries in the cache are skipped.  This does not take
+    /// ownership of the reader or the cache.
+    TEventPrefetcher(CP::TEventReader* reader, int depth,
+                     const CP::TEventCache* cache = NULL);
+
+    /// Stop the reader thread and delete any events still in the ring.
+    ~TEventPrefetcher();
+
+    /// Set the entry that is being displayed.  The reader thread will fill
+    /// the ring around this entry.  The center entry itself is never read
+    /// since it is owned by the event display.
+    void SetCenter(int entry);
+
+    /// Remove an event from the ring and return it.  If the entry is being
+    /// read, this waits for the read to finish.  The caller takes ownership
+    /// of the event.  This returns NULL if the entry is not in the ring.
+    CP::TEvent* Take(int entry);
+
+    /// Get the number of entries to keep on each side of the center.
+    int GetDepth() const {return fDepth;}
+
+private:
+
+    /// The function run by the reader thread.
+    static void* ThreadFunction(void* self);
+
+    /// The body of the reader thread.
+    void Run();
+
+    /// Find the next entry that should be read.  This must be called with
+    /// the mutex held.  It returns -1 if the ring is full.  An entry in the
+    /// cache is not read.
+    int NextMissingEntry();
+
+    /// Check if an entry isn't in the ring or the cache.  This must be
+    /// called with the mutex held.
+    bool IsMissing(int entry) const;
+
+    /// Delete the events that are outside of the ring.  This must be called
+    /// with the mutex held.
+    void TrimRing();
+
+    /// The source of the events.
+    CP::TEventReader* fReader;
+
+    /// The cache of displayed events (may be NULL).
+    const CP::TEventCache* fCache;
+
+    /// The number of entries to keep on each side of the center.
+    int fDepth;
+
+    /// The entry being displayed.
+    int fCenter;
+
+    /// The entry being read by the reader thread, or -1.
+    int fReading;
+
+    /// The first entry that is known not to exist, or -1 if the end of the
+    /// file hasn't been found.
+    int fEndEntry;
+
+    /// A flag to tell the reader thread to stop.
+    bool fStop;
+
+    /// The events that have been read, keyed by entry.
+    typedef std::map<int, CP::TEvent*> Ring;
+    Ring fRing;
+
+    /// The reader thread.
+    TThread* fThread;
+
+    /// Protect the ring and the state variables.
+    TMutex* fMutex;
+
+    /// Signaled when the center changes, or an event has been read.
+    TCondition* fCondition;
+};
+#endif
@@ -0,0 +1,308 @@
+#include "TEventReader.hxx"
+#include "TEventIndex.hxx"
+#include "TEventTree.hxx"
+#include "TChainedInput.hxx"
+#include "TDisplayTimer.hxx"
+
+#include <TCaptLog.hxx>
+#include <TEvent.hxx>
+#include <TEventFolder.hxx>
+#include <TVInputFile.hxx>
+#include <TRootInput.hxx>
+#include <TDataVector.hxx>
+#include <THandle.hxx>
+
+#include <TMutex.h>
+#include <TVirtualMutex.h>
+#include <TCollection.h>
+
+#include <vector>
+#include <string>
+
+namespace {
+    /// Remove the leading "~/" from a path in the event.
+    std::string NormalizePath(const std::string& path) {
+        if (path.compare(0,2,"~/") == 0) return path.substr(2);
+        return path;
+    }
+
+    /// Load the index for a file from the sidecar, or build it from the
+    /// tree of events and save it.
+    void LoadIndex(CP::TEventIndex& index, const std::string& fileName) {
+        if (index.Load(fileName)) return;
+        CP::TEventTree tree(fileName);
+        if (!index.Build(tree)) {
+            CaptWarn("Event index for " << fileName << " is incomplete");
+            return;
+        }
+        index.Save(fileName);
+    }
+};
+
+CP::TEventReader::TEventReader(CP::TVInputFile* input)
+    : fInput(input), fTree(NULL), fPosition(-1), fIndex(NULL) {
+    fMutex = new TMutex();
+
+    // The ROOT input registers the events it reads in the event folder, so
+    // the reader opens its own copy of the file.
+    if (dynamic_cast<CP::TRootInput*>(fInput)) {
+        fTree = new CP::TEventTree(fInput->GetInputName());
+        if (!fTree->IsOpen()) {
+            CaptWarn("Step through " << fInput->GetInputName());
+            delete fTree;
+            fTree = NULL;
+        }
+    }
+}
+
+CP::TEventReader::~TEventReader() {
+    if (fIndex) delete fIndex;
+    if (fTree) delete fTree;
+    delete fMutex;
+}
+
+bool CP::TEventReader::HasDirectRead() const {
+    if (fTree) return true;
+    return dynamic_cast<CP::TChainedInput*>(fInput) != NULL;
+}
+
+int CP::TEventReader::GetEntryCount() {
+    TLockGuard lock(fMutex);
+    if (fTree) return fTree->GetEntryCount();
+    CP::TRootInput* rootInput = dynamic_cast<CP::TRootInput*>(fInput);
+    if (rootInput) return rootInput->GetEventsInFile();
+    CP::TChainedInput* chain = dynamic_cast<CP::TChainedInput*>(fInput);
+    if (chain) return chain->GetEventsInFile();
+    return -1;
+}
+
+void CP::TEventReader::Refresh() {
+    TLockGuard lock(fMutex);
+    if (fTree) fTree->Refresh();
+}
+
+int CP::TEventReader::GetEntryBytes(int entry) {
+    TLockGuard lock(fMutex);
+    if (fTree) return fTree->GetEntryBytes(entry);
+    CP::TChainedInput* chain = dynamic_cast<CP::TChainedInput*>(fInput);
+    if (!chain) return -1;
+    int file = chain->FindFile(entry);
+    if (file < 0) return -1;
+    CP::TEventTree* tree = chain->GetFileTree(file);
+    if (!tree) return -1;
+    return tree->GetEntryBytes(entry - chain->GetFirstEntry(file));
+}
+
+CP::TEvent* CP::TEventReader::ReadEntry(int entry) {
+    if (entry < 0) return NULL;
+    TLockGuard lock(fMutex);
+    CP::TEvent* event = ReadFullEntry(entry);
+
+    // Nothing is missing from a freshly read event.
+    if (event) fPrunedPaths.erase(entry);
+    return event;
+}
+
+CP::TEvent* CP::TEventReader::ReadFullEntry(int entry) {
+    CP::TDisplayTimer timer("read entry");
+    // The tree of events (or the chained trees) can be read directly, and
+    // the events aren't put into the event folder.
+    if (fTree) return fTree->ReadEvent(entry);
+    CP::TChainedInput* chain = dynamic_cast<CP::TChainedInput*>(fInput);
+    if (chain) return chain->ReadEvent(entry);
+
+    CP::TEvent* event = NULL;
+    if (0 <= fPosition && fPosition < entry) {
+        event = fInput->NextEvent(entry-fPosition-1);
+    }
+    else if (entry < fPosition) {
+        event = fInput->PreviousEvent(fPosition-entry-1);
+    }
+    else {
+        // This is the first read, or the entry is being reread, so start
+        // from the beginning of the file.
+        event = fInput->FirstEvent();
+        if (event && entry > 0) {
+            delete event;
+            event = fInput->NextEvent(entry-1);
+        }
+    }
+
+    if (!event) {
+        // The file position isn't known after a failed read, so the next
+        // read will start from the beginning.
+        fPosition = -1;
+        return NULL;
+    }
+    fPosition = entry;
+
+    // The stepping interface registers the event in the event folder.
+    CP::TEventFolder::GetEventFolder()->Remove(event);
+    return event;
+}
+
+void CP::TEventReader::AddPrunedFolder(const std::string& folder) {
+    TLockGuard lock(fMutex);
+    fPrunedFolders.push_back(folder);
+}
+
+void CP::TEventReader::AddRequiredPath(const std::string& path) {
+    TLockGuard lock(fMutex);
+    fRequiredPaths.insert(NormalizePath(path));
+}
+
+void CP::TEventReader::PruneEvent(CP::TEvent* event, int entry) {
+    if (!event || entry < 0) return;
+    TLockGuard lock(fMutex);
+
+    // The event may already have been pruned, so the new paths are added
+    // to the ones that are already missing.
+    std::set<std::string> pruned;
+    std::map<int, std::set<std::string> >::iterator prunedEntry
+        = fPrunedPaths.find(entry);
+    if (prunedEntry != fPrunedPaths.end()) pruned = prunedEntry->second;
+    for (std::vector<std::string>::iterator f = fPrunedFolders.begin();
+         f != fPrunedFolders.end(); ++f) {
+        CP::THandle<CP::TDataVector> folder = event->Get<CP::TDataVector>(
+            f->c_str());
+        if (!folder) continue;
+        std::vector<CP::TDatum*> unused;
+        for (CP::TDataVector::iterator d = folder->begin();
+             d != folder->end(); ++d) {
+            std::string path = *f + "/" + (*d)->GetName();
+            if (fRequiredPaths.find(path) != fRequiredPaths.end()) continue;
+            unused.push_back(*d);
+            pruned.insert(path);
+        }
+        for (std::vector<CP::TDatum*>::iterator d = unused.begin();
+             d != unused.end(); ++d) {
+            folder->RemoveDatum(*d);
+            delete (*d);
+        }
+    }
+    if (pruned.empty()) fPrunedPaths.erase(entry);
+    else fPrunedPaths[entry] = pruned;
+}
+
+void CP::TEventReader::ForgetPrunedPaths(const std::set<int>& keep) {
+    TLockGuard lock(fMutex);
+    std::map<int, std::set<std::string> >::iterator p = fPrunedPaths.begin();
+    while (p != fPrunedPaths.end()) {
+        if (keep.find(p->first) == keep.end()) fPrunedPaths.erase(p++);
+        else ++p;
+    }
+}
+
+bool CP::TEventReader::LoadEventPaths(CP::TEvent* event, int entry,
+                                      const std::vector<std::string>& paths) {
+    if (!event || entry < 0) return false;
+    TLockGuard lock(fMutex);
+
+    // Find the requested paths that were removed from this entry.
+    std::map<int, std::set<std::string> >::iterator prunedEntry
+        = fPrunedPaths.find(entry);
+    if (prunedEntry == fPrunedPaths.end()) return true;
+    std::set<std::string>& pruned = prunedEntry->second;
+    std::vector<std::string> missing;
+    for (std::vector<std::string>::const_iterator p = paths.begin();
+         p != paths.end(); ++p) {
+        std::string path = NormalizePath(*p);
+        if (pruned.find(path) == pruned.end()) continue;
+        missing.push_back(path);
+    }
+    if (missing.empty()) return true;
+
+    CP::TEvent* full = ReadFullEntry(entry);
+    if (!full) return false;
+    CaptLog("Load " << missing.size() << " pruned paths for entry " << entry);
+
+    // Move the missing data from the freshly read event into the event
+    // being displayed.
+    for (std::vector<std::string>::iterator p = missing.begin();
+         p != missing.end(); ++p) {
+        std::size_t slash = p->rfind('/');
+        std::string parent = p->substr(0,slash);
+        std::string name = p->substr(slash+1);
+        CP::THandle<CP::TDataVector> source
+            = full->Get<CP::TDataVector>(parent.c_str());
+        CP::THandle<CP::TDataVector> target
+            = event->Get<CP::TDataVector>(parent.c_str());
+        if (!source || !target) continue;
+        if (target->Get<CP::TDatum>(name.c_str())) {
+            // The event already has the data.
+            pruned.erase(*p);
+            continue;
+        }
+        CP::TDatum* datum = NULL;
+        for (CP::TDataVector::iterator d = source->begin();
+             d != source->end(); ++d) {
+            if (name != (*d)->GetName()) continue;
+            datum = *d;
+            break;
+        }
+        if (!datum) continue;
+        source->RemoveDatum(datum);
+        target->AddDatum(datum);
+        pruned.erase(*p);
+    }
+    delete full;
+    if (pruned.empty()) fPrunedPaths.erase(prunedEntry);
+
+    return true;
+}
+
+const CP::TEventIndex& CP::TEventReader::GetIndex() {
+    if (fIndex) return *fIndex;
+
+    // The index is built from a separate copy of each file, so the reader
+    // isn't locked while the index is built.
+    CP::TEventIndex* index = new CP::TEventIndex();
+    CP::TChainedInput* chain = dynamic_cast<CP::TChainedInput*>(fInput);
+    if (chain) {
+        // Each file in the chain has its own sidecar so that a file can be
+        // shared between chains.  The merged index is only kept in memory.
+        for (int i = 0; i < chain->GetFileCount(); ++i) {
+            const std::string& fileName = chain->GetFileName(i);
+            CP::TEventIndex fileIndex;
+            LoadIndex(fileIndex, fileName);
+            if (fileIndex.GetEntryCount() != chain->GetFileEntries(i)) {
+                CaptWarn("Event index doesn't match " << fileName);
+            }
+            index->Append(fileIndex);
+        }
+        index->Finalize();
+    }
+    else if (fTree) {
+        LoadIndex(*index, fInput->GetInputName());
+    }
+    else {
+        CaptError("No event index for " << fInput->GetInputName());
+    }
+
+    TLockGuard lock(fMutex);
+    fIndex = index;
+    return *fIndex;
+}
+
+void CP::TEventReader::Attach(CP::TEvent* event) {
+    if (!event) return;
+    TLockGuard lock(fMutex);
+    CP::TEventFolder* folder = CP::TEventFolder::GetEventFolder();
+    std::vector<TObject*> others;
+    TIter next(folder->GetListOfFolders());
+    TObject* obj;
+    while ((obj = next())) {
+        if (obj != event) others.push_back(obj);
+    }
+    for (std::vector<TObject*>::iterator o = others.begin();
+         o != others.end(); ++o) {
+        folder->Remove(*o);
+    }
+    if (!folder->GetListOfFolders()->FindObject(event)) folder->Add(event);
+}
+
+void CP::TEventReader::Detach(CP::TEvent* event) {
+    if (!event) return;
+    TLockGuard lock(fMutex);
+    CP::TEventFolder::GetEventFolder()->Remove(event);
+}
@@ -0,0 +1,156 @@
+#ifndef TEventReader_hxx_seen
+#define TEventReader_hxx_seen
+
+#include <vector>
+#include <set>
+#include <map>
+#include <string>
+
+namespace CP {
+    class TEventReader;
+    class TVInputFile;
+    class TEvent;
+    class TEventIndex;
+    class TEventTree;
+};
+
+class TMutex;
+
+/// Provide entry based (random) access to the events in a TVInputFile.  The
+/// TVInputFile interface only knows how to step forward and backward through
+/// a file, so this keeps track of the current position.  A TRootInput (or a
+/// TChainedInput) is read directly from its tree of events instead (see
+/// TEventTree).  The direct reads don't touch the event folder, so they can
+/// be made on a background reader thread while the GUI thread is using the
+/// current event.  All access to the input file is serialized so that a
+/// reader can be shared between the GUI thread and a reader thread.
+///
+/// Folders that hold bulky data (e.g. "digits") can be pruned from the
+/// events that are kept for later (i.e. in the prefetch ring, or the event
+/// cache) so that the saved events use less memory.  The data in a pruned
+/// folder is still read and decoded with the rest of the event (it isn't
+/// split into its own branch), and is then removed unless it has been
+/// declared as required.  The removed data is read again by
+/// LoadEventPaths() if it's needed once the event is displayed.
+///
+/// Pruning only saves memory.  It doesn't make reading an entry any faster,
+/// since the whole entry is always read and decoded.  An event read by
+/// ReadEntry() for display is never pruned, so drawing its digits doesn't
+/// read the file again.  The limitation is that a pruned event taken from
+/// the prefetch ring or the cache costs a second full read of the entry the
+/// first time its pruned data is requested (e.g. by "Draw X Digits").
+///
+/// Events returned by ReadEntry() are detached from the event folder and are
+/// owned by the caller.  Use Attach() to make an event the current event
+/// (i.e. the one returned by TEventFolder::GetCurrentEvent()).
+class CP::TEventReader {
+public:
+    /// Create a reader for an input file.  The reader does not take
+    /// ownership of the input file.
+    explicit TEventReader(CP::TVInputFile* input);
+    ~TEventReader();
+
+    /// Get the input file being read.
+    CP::TVInputFile* GetInput() {return fInput;}
+
+    /// Check if the entries are read directly from the tree of events.  The
+    /// stepping interface of other inputs registers the events in the event
+    /// folder, so those inputs must only be read on the GUI thread.
+    bool HasDirectRead() const;
+
+    /// Get the number of entries in the input file.  This returns -1 if the
+    /// number of entries can't be determined.
+    int GetEntryCount();
+
+    /// Look for entries written to the input file since it was opened.
+    /// This only works for a single ROOT file (see TEventTree::Refresh()).
+    void Refresh();
+
+    /// Get the size of an entry in the file.  This is found from the sizes
+    /// of the baskets holding the entry (see TEventTree::GetEntryBytes()),
+    /// so nothing is read.  This returns -1 if the input isn't read
+    /// directly (see HasDirectRead()).
+    int GetEntryBytes(int entry);
+
+    /// Read an entry from the file.  The entry is counted from zero.  This
+    /// returns NULL if the entry is not available.  The event is complete
+    /// (nothing is pruned), is detached from the event folder, and must be
+    /// deleted by the caller.
+    CP::TEvent* ReadEntry(int entry);
+
+    /// Add a folder (e.g. "digits") that is pruned by PruneEvent().
+    void AddPrunedFolder(const std::string& folder);
+
+    /// Declare that a path (e.g. "digits/drift") is always needed, so it is
+    /// kept even if it's in a pruned folder.
+    void AddRequiredPath(const std::string& path);
+
+    /// Remove the data in the pruned folders that isn't required from an
+    /// event that was read from the entry.  The removed paths are remembered
+    /// so that LoadEventPaths() can restore them.
+    void PruneEvent(CP::TEvent* event, int entry);
+
+    /// Forget the paths that were pruned from the entries that aren't in
+    /// the set.  The events for those entries have been deleted, so this
+    /// bounds the memory used to remember what was pruned.
+    void ForgetPrunedPaths(const std::set<int>& keep);
+
+    /// Make sure that the data at the paths is loaded into an event that was
+    /// read from the entry.  If data was pruned from the event, the entry is
+    /// read again (the whole event is decoded), and the data is added back
+    /// to the event.  This returns false if the entry can't be read.
+    bool LoadEventPaths(CP::TEvent* event, int entry,
+                        const std::vector<std::string>& paths);
+
+    /// Get the index of the events in the input file.  The index is read
+    /// from the sidecar file the first time it is requested.  If the sidecar
+    /// is missing or out of date, the index is built from the tree of events
+    /// (this reads the event context of every entry) and saved.  For a
+    /// TChainedInput, the index is merged from the sidecars of each file in
+    /// the chain.  The index is empty if the input isn't read directly (see
+    /// HasDirectRead()).  This should only be called from the GUI thread.
+    const CP::TEventIndex& GetIndex();
+
+    /// Check if the index has been loaded (or built).
+    bool HasIndex() const {return fIndex != NULL;}
+
+    /// Make an event the current event in the event folder.  The event
+    /// folder is expected to only hold the event being displayed, so this
+    /// detaches any other event that is in the folder.
+    void Attach(CP::TEvent* event);
+
+    /// Remove an event from the event folder without deleting it.
+    void Detach(CP::TEvent* event);
+
+private:
+
+    /// Read an entry.  The mutex must be held.
+    CP::TEvent* ReadFullEntry(int entry);
+
+    /// The input file being read.
+    CP::TVInputFile* fInput;
+
+    /// The tree of events when the input is a TRootInput, otherwise NULL.
+    CP::TEventTree* fTree;
+
+    /// The entry of the last event read through the TVInputFile stepping
+    /// interface, or -1 if the file hasn't been read yet.
+    int fPosition;
+
+    /// The index of the events in the input file (NULL until it's built).
+    CP::TEventIndex* fIndex;
+
+    /// The folders that are pruned.
+    std::vector<std::string> fPrunedFolders;
+
+    /// The paths that are always loaded.
+    std::set<std::string> fRequiredPaths;
+
+    /// The paths removed from each entry that is still held by the event
+    /// display.
+    std::map<int, std::set<std::string> > fPrunedPaths;
+
+    /// Serialize access to the input file and the event folder.
+    TMutex* fMutex;
+};
+#endif
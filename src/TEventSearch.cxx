@@ -0,0 +1,207 @@
+#include "TEventSearch.hxx"
+#include "TVEventPredicate.hxx"
+#include "TEventTree.hxx"
+#include "TDisplayTimer.hxx"
+
+#include <TCaptLog.hxx>
+#include <TEvent.hxx>
+#include <THandle.hxx>
+#include <THitSelection.hxx>
+#include <THit.hxx>
+#include <TReconBase.hxx>
+
+#include <TThread.h>
+#include <TMutex.h>
+#include <TVirtualMutex.h>
+#include <TSystem.h>
+
+#include <sstream>
+
+namespace {
+    /// Select events with more than a number of drift hits.
+    class DriftHitPredicate: public CP::TVEventPredicate {
+    public:
+        explicit DriftHitPredicate(int hits) : fHits(hits) {}
+        bool operator () (CP::TEvent& event) const {
+            CP::THandle<CP::THitSelection> hits
+                = event.Get<CP::THitSelection>("~/hits/drift");
+            if (!hits) return false;
+            return (int) hits->size() > fHits;
+        }
+    private:
+        int fHits;
+    };
+
+    /// Select events with a PMT hit charge over a threshold.
+    class PMTChargePredicate: public CP::TVEventPredicate {
+    public:
+        explicit PMTChargePredicate(double charge) : fCharge(charge) {}
+        bool operator () (CP::TEvent& event) const {
+            CP::THandle<CP::THitSelection> pmts
+                = event.Get<CP::THitSelection>("~/hits/pmt");
+            if (!pmts) return false;
+            for (CP::THitSelection::iterator h = pmts->begin();
+                 h != pmts->end(); ++h) {
+                if ((*h)->GetCharge() > fCharge) return true;
+            }
+            return false;
+        }
+    private:
+        double fCharge;
+    };
+
+    /// Select events that contain a reconstruction container.
+    class ContainerPredicate: public CP::TVEventPredicate {
+    public:
+        explicit ContainerPredicate(const std::string& name) : fName(name) {}
+        bool operator () (CP::TEvent& event) const {
+            CP::THandle<CP::TReconObjectContainer> objects
+                = event.Get<CP::TReconObjectContainer>(fName.c_str());
+            if (!objects) return false;
+            return true;
+        }
+    private:
+        std::string fName;
+    };
+};
+
+CP::TEventSearch::TEventSearch(const std::string& inputName, int workers)
+    : fPredicate(NULL), fNext(0), fLast(-1), fFound(-1), fTested(0),
+      fRunning(0) {
+    CP::TEventTree::EnableThreads();
+    fMutex = new TMutex();
+
+    // Open the files for the workers on this thread so that a file that
+    // can't be read is reported before the search starts.
+    for (int i = 0; i < workers; ++i) {
+        Worker worker;
+        worker.fSearch = this;
+        worker.fThread = NULL;
+        worker.fEvent = NULL;
+        worker.fTree = new CP::TEventTree(inputName);
+        if (!worker.fTree->IsOpen()) {
+            CaptError("Search cannot read " << inputName);
+            delete worker.fTree;
+            break;
+        }
+        fWorkers.push_back(worker);
+    }
+}
+
+CP::TEventSearch::~TEventSearch() {
+    for (std::vector<Worker>::iterator w = fWorkers.begin();
+         w != fWorkers.end(); ++w) {
+        delete w->fTree;
+    }
+    delete fMutex;
+}
+
+CP::TVEventPredicate* CP::TEventSearch::MakePredicate(
+    const std::string& text) {
+    std::istringstream input(text);
+    std::string what;
+    input >> what;
+    if (what == "container") {
+        std::string name;
+        input >> name;
+        if (name.empty()) return NULL;
+        return new ContainerPredicate(name);
+    }
+    std::string op;
+    double value;
+    input >> op >> value;
+    if (!input || op != ">") return NULL;
+    if (what == "drift") return new DriftHitPredicate((int) value);
+    if (what == "pmt") return new PMTChargePredicate(value);
+    return NULL;
+}
+
+int CP::TEventSearch::Find(const CP::TVEventPredicate& predicate,
+                           int first, int last) {
+    if (fWorkers.empty()) return -1;
+
+    fPredicate = &predicate;
+    fNext = first;
+    fLast = last;
+    fFound = -1;
+    fTested = 0;
+    fRunning = fWorkers.size();
+
+    CaptLog("Search entries " << first << " to " << last
+            << " with " << fWorkers.size() << " threads");
+    for (std::vector<Worker>::iterator w = fWorkers.begin();
+         w != fWorkers.end(); ++w) {
+        w->fThread = new TThread("eventSearch",
+                                 &CP::TEventSearch::ThreadFunction,
+                                 &(*w));
+        w->fThread->Run();
+    }
+
+    // Wait for the workers while keeping the GUI responsive.
+    int lastReport = 0;
+    while (true) {
+        fMutex->Lock();
+        int running = fRunning;
+        int tested = fTested;
+        fMutex->UnLock();
+        if (running < 1) break;
+        if (tested - lastReport >= 100) {
+            CaptLog("Searched " << tested << " of " << last-first+1
+                    << " entries");
+            lastReport = tested;
+        }
+        gSystem->ProcessEvents();
+        gSystem->Sleep(20);
+    }
+
+    for (std::vector<Worker>::iterator w = fWorkers.begin();
+         w != fWorkers.end(); ++w) {
+        w->fThread->Join();
+        delete w->fThread;
+        w->fThread = NULL;
+    }
+
+    CaptLog("Searched " << fTested << " entries and found " << fFound);
+    fPredicate = NULL;
+    return fFound;
+}
+
+void* CP::TEventSearch::ThreadFunction(void* worker) {
+    Worker* w = static_cast<Worker*>(worker);
+    w->fSearch->Run(*w);
+    return NULL;
+}
+
+void CP::TEventSearch::Run(Worker& worker) {
+    while (true) {
+        // Take the next entry.  Entries after a match don't need to be
+        // tested.
+        fMutex->Lock();
+        int entry = fNext++;
+        bool done = (entry > fLast) || (0 <= fFound && fFound < entry);
+        fMutex->UnLock();
+        if (done) break;
+
+        bool selected = false;
+        if (ReadEntry(worker, entry)) {
+            selected = (*fPredicate)(*worker.fEvent);
+        }
+        delete worker.fEvent;
+        worker.fEvent = NULL;
+
+        fMutex->Lock();
+        ++fTested;
+        if (selected && (fFound < 0 || entry < fFound)) fFound = entry;
+        fMutex->UnLock();
+    }
+
+    fMutex->Lock();
+    --fRunning;
+    fMutex->UnLock();
+}
+
+bool CP::TEventSearch::ReadEntry(Worker& worker, int entry) {
+    CP::TDisplayTimer timer("search entry");
+    worker.fEvent = worker.fTree->ReadEvent(entry);
+    return (worker.fEvent != NULL);
+}
@@ -0,0 +1,87 @@
+#ifndef TEventSearch_hxx_seen
+#define TEventSearch_hxx_seen
+
+#include <string>
+#include <vector>
+
+namespace CP {
+    class TEventSearch;
+    class TVEventPredicate;
+    class TEvent;
+    class TEventTree;
+};
+
+class TThread;
+class TMutex;
+
+/// Search forward through an input file for the first event that matches a
+/// predicate.  The search uses a pool of worker threads.  Each worker
+/// opens its own copy of the input file (see TEventTree), and reads and
+/// tests entries independently.  The entries are handed out in order, so
+/// the search stops as soon as every entry before the first match has been
+/// tested.
+class CP::TEventSearch {
+public:
+    /// Create a search of an input file using several worker threads.
+    TEventSearch(const std::string& inputName, int workers);
+    ~TEventSearch();
+
+    /// Find the first entry between first and last (inclusive) that is
+    /// selected by the predicate.  This waits for the search to finish, but
+    /// keeps the GUI alive and logs the progress while it waits.  This
+    /// returns -1 if no entry is selected.
+    int Find(const CP::TVEventPredicate& predicate, int first, int last);
+
+    /// Make a predicate from a text description.  This returns NULL if the
+    /// description isn't understood.  The caller owns the predicate.  The
+    /// understood descriptions are
+    ///
+    ///  - "drift > N" -- Select events with more than N drift hits.
+    ///  - "pmt > Q" -- Select events with a PMT hit charge more than Q.
+    ///  - "container NAME" -- Select events with the named recon container.
+    static CP::TVEventPredicate* MakePredicate(const std::string& text);
+
+private:
+
+    /// The state of a worker thread.
+    struct Worker {
+        CP::TEventSearch* fSearch;
+        TThread* fThread;
+        CP::TEventTree* fTree;
+        CP::TEvent* fEvent;
+    };
+
+    /// The function run by a worker thread.
+    static void* ThreadFunction(void* worker);
+
+    /// The body of a worker thread.
+    void Run(Worker& worker);
+
+    /// Read an entry for a worker.  The event is left in worker.fEvent.
+    bool ReadEntry(Worker& worker, int entry);
+
+    /// The workers.
+    std::vector<Worker> fWorkers;
+
+    /// The predicate being used for the current search.
+    const CP::TVEventPredicate* fPredicate;
+
+    /// The next entry to be tested.
+    int fNext;
+
+    /// The last entry to be tested.
+    int fLast;
+
+    /// The first selected entry, or -1.
+    int fFound;
+
+    /// The number of entries tested.
+    int fTested;
+
+    /// The number of worker threads still running.
+    int fRunning;
+
+    /// Protect the search state.
+    TMutex* fMutex;
+};
+#endif
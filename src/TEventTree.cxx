@@ -0,0 +1,184 @@
+#include "TEventTree.hxx"
+
+#include <TCaptLog.hxx>
+#include <TEvent.hxx>
+#include <TEventContext.hxx>
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TBranch.h>
+#include <TObjArray.h>
+#include <TKey.h>
+#include <TClass.h>
+#include <TDirectory.h>
+#include <TThread.h>
+#include <TMutex.h>
+#include <TVirtualMutex.h>
+#include <RVersion.h>
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,6,0)
+#include <TROOT.h>
+#endif
+
+#include <algorithm>
+
+namespace {
+    /// Add a branch and all of its sub-branches to a list.
+    void AddBranches(TBranch* branch, std::vector<TBranch*>& branches) {
+        branches.push_back(branch);
+        TObjArray* subBranches = branch->GetListOfBranches();
+        for (int i = 0; i < subBranches->GetEntriesFast(); ++i) {
+            AddBranches((TBranch*) subBranches->At(i), branches);
+        }
+    }
+
+    /// Check if a name ends with a suffix.
+    bool EndsWith(const std::string& name, const std::string& suffix) {
+        if (name.size() < suffix.size()) return false;
+        return name.compare(name.size()-suffix.size(),
+                            suffix.size(), suffix) == 0;
+    }
+};
+
+TMutex* CP::TEventTree::fIOMutex = NULL;
+
+void CP::TEventTree::EnableThreads() {
+    TThread::Initialize();
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,6,0)
+    ROOT::EnableThreadSafety();
+#else
+    if (!fIOMutex) fIOMutex = new TMutex();
+#endif
+}
+
+CP::TEventTree::TEventTree(const std::string& fileName)
+    : fFileName(fileName), fFile(NULL), fTree(NULL), fBranch(NULL),
+      fContextOnly(false), fEvent(NULL) {
+    TLockGuard lock(fIOMutex);
+    TDirectory* saveDirectory = gDirectory;
+    fFile = TFile::Open(fFileName.c_str(), "READ");
+    if (saveDirectory) saveDirectory->cd();
+    if (!fFile || fFile->IsZombie()) {
+        CaptError("Cannot open " << fFileName);
+        return;
+    }
+
+    // Find the tree holding the events.  It's the tree where the first
+    // branch holds a CP::TEvent.
+    TIter next(fFile->GetListOfKeys());
+    TKey* key;
+    while ((key = (TKey*) next())) {
+        if (std::string(key->GetClassName()) != "TTree") continue;
+        TTree* tree = dynamic_cast<TTree*>(key->ReadObj());
+        if (!tree) continue;
+        TBranch* branch = (TBranch*) tree->GetListOfBranches()->At(0);
+        TClass* branchClass = NULL;
+        if (branch) branchClass = TClass::GetClass(branch->GetClassName());
+        if (!branchClass || !branchClass->InheritsFrom("CP::TEvent")) {
+            continue;
+        }
+        fTree = tree;
+        fBranch = branch;
+        break;
+    }
+    if (!fTree) {
+        CaptError("Cannot find the events in " << fFileName);
+        return;
+    }
+    fBranch->SetAddress(&fEvent);
+
+    // When the event is split, the run and event numbers are in their own
+    // branches and can be read without the rest of the event.
+    AddBranches(fBranch, fBranches);
+    bool foundRun = false;
+    bool foundEvent = false;
+    for (std::vector<TBranch*>::iterator b = fBranches.begin();
+         b != fBranches.end(); ++b) {
+        std::string name((*b)->GetName());
+        if (EndsWith(name, "fContext.fRun")) {
+            foundRun = true;
+            fContextBranches = name.substr(0, name.size()-4) + "*";
+        }
+        if (EndsWith(name, "fContext.fEvent")) foundEvent = true;
+    }
+    if (!foundRun || !foundEvent) fContextBranches.clear();
+}
+
+CP::TEventTree::~TEventTree() {
+    TLockGuard lock(fIOMutex);
+    if (fEvent) delete fEvent;
+    if (fFile) delete fFile;
+}
+
+int CP::TEventTree::GetEntryCount() const {
+    if (!fTree) return -1;
+    return fTree->GetEntries();
+}
+
+CP::TEvent* CP::TEventTree::ReadEvent(int entry) {
+    if (!fTree || entry < 0 || entry >= GetEntryCount()) return NULL;
+    if (fContextOnly) {
+        TLockGuard lock(fIOMutex);
+        fTree->SetBranchStatus("*",1);
+        fContextOnly = false;
+    }
+    return ReadBranches(entry);
+}
+
+bool CP::TEventTree::ReadContext(int entry, int& run, int& event) {
+    if (!fTree || entry < 0 || entry >= GetEntryCount()) return false;
+    if (!fContextBranches.empty() && !fContextOnly) {
+        TLockGuard lock(fIOMutex);
+        fTree->SetBranchStatus("*",0);
+        fTree->SetBranchStatus(fContextBranches.c_str(),1);
+        fContextOnly = true;
+    }
+    CP::TEvent* read = ReadBranches(entry);
+    if (!read) return false;
+    run = read->GetContext().GetRun();
+    event = read->GetContext().GetEvent();
+    delete read;
+    return true;
+}
+
+void CP::TEventTree::Refresh() {
+    if (!fTree) return;
+    TLockGuard lock(fIOMutex);
+    fTree->Refresh();
+    fBranch->SetAddress(&fEvent);
+}
+
+int CP::TEventTree::GetEntryBytes(int entry) const {
+    if (!fTree || entry < 0 || entry >= GetEntryCount()) return 0;
+    double bytes = 0.0;
+    for (std::vector<TBranch*>::const_iterator b = fBranches.begin();
+         b != fBranches.end(); ++b) {
+        int baskets = (*b)->GetWriteBasket();
+        const Long64_t* first = (*b)->GetBasketEntry();
+        const Int_t* sizes = (*b)->GetBasketBytes();
+        if (baskets < 1 || !first || !sizes) continue;
+        // Find the last basket starting at or before the entry.
+        int basket = std::upper_bound(first, first+baskets, (Long64_t) entry)
+            - first - 1;
+        if (basket < 0) continue;
+        Long64_t next = (*b)->GetEntries();
+        if (basket+1 < baskets) next = first[basket+1];
+        if (next <= first[basket]) continue;
+        bytes += double(sizes[basket])/(next - first[basket]);
+    }
+    return (int) (bytes + 0.5);
+}
+
+CP::TEvent* CP::TEventTree::ReadBranches(int entry) {
+    // Make ROOT create a new event for each entry so that the event can be
+    // handed to the caller.
+    TLockGuard lock(fIOMutex);
+    fEvent = NULL;
+    if (fTree->GetEntry(entry) <= 0) {
+        if (fEvent) delete fEvent;
+        fEvent = NULL;
+        return NULL;
+    }
+    CP::TEvent* event = fEvent;
+    fEvent = NULL;
+    return event;
+}
@@ -0,0 +1,108 @@
+#ifndef TEventTree_hxx_seen
+#define TEventTree_hxx_seen
+
+#include <string>
+#include <vector>
+
+namespace CP {
+    class TEventTree;
+    class TEvent;
+};
+
+class TFile;
+class TTree;
+class TBranch;
+class TMutex;
+
+/// A private handle on the tree of events in a ROOT event file.  The events
+/// are read directly from the tree, so unlike the events read through
+/// TRootInput, they are never registered in the global event folder.  This
+/// means an event can be read on a worker thread while the GUI thread is
+/// using the current event in the folder.  Each handle opens its own copy of
+/// the file, and a handle must only be used by one thread at a time.
+///
+/// Trees must not be read on several threads until EnableThreads() has been
+/// called.
+class CP::TEventTree {
+public:
+    /// Open a file and find the tree of events.  The global ROOT directory
+    /// is restored after the file is opened.  Use IsOpen() to check that
+    /// the events were found.
+    explicit TEventTree(const std::string& fileName);
+
+    /// Close the file.
+    ~TEventTree();
+
+    /// Check if the tree of events was found.
+    bool IsOpen() const {return fTree != NULL;}
+
+    /// Get the name of the file.
+    const std::string& GetFileName() const {return fFileName;}
+
+    /// Get the number of entries in the tree, or -1 if it isn't open.
+    int GetEntryCount() const;
+
+    /// Read an entry from the tree.  This returns NULL if the entry can't
+    /// be read.  The event isn't in the event folder, and must be deleted by
+    /// the caller.
+    CP::TEvent* ReadEvent(int entry);
+
+    /// Read the run and event number of an entry.  When the events are
+    /// split into branches, only the branches of the event context are
+    /// read.  Otherwise, the whole event has to be read.  This returns false
+    /// if the entry can't be read.
+    bool ReadContext(int entry, int& run, int& event);
+
+    /// Read the tree metadata again so that the entries written to the file
+    /// since it was opened can be read.  This is used to follow a file that
+    /// is still being written.
+    void Refresh();
+
+    /// Get the size of an entry in the file.  This is found from the sizes
+    /// of the (compressed) baskets holding the entry, so nothing is read.
+    /// Each entry in a basket is charged an equal share of the basket.
+    int GetEntryBytes(int entry) const;
+
+    /// Prepare ROOT so that trees can be opened and read on several threads.
+    /// For ROOT 6, this enables the ROOT thread safety (so each thread has
+    /// its own current directory).  Older versions of ROOT can't read files
+    /// on several threads, so the trees are opened and read one at a time.
+    /// This must be called on the GUI thread before a thread that reads a
+    /// tree is started.
+    static void EnableThreads();
+
+private:
+    /// Read an entry from the branches that are enabled.
+    CP::TEvent* ReadBranches(int entry);
+
+    /// The name of the file.
+    std::string fFileName;
+
+    /// The file holding the events.
+    TFile* fFile;
+
+    /// The tree of events (NULL if it wasn't found).
+    TTree* fTree;
+
+    /// The branch holding the events.
+    TBranch* fBranch;
+
+    /// The branch holding the events and all of its sub-branches.
+    std::vector<TBranch*> fBranches;
+
+    /// The pattern matching the branches of the event context, or empty if
+    /// the context isn't in a separate branch.
+    std::string fContextBranches;
+
+    /// True if only the context branches are enabled.
+    bool fContextOnly;
+
+    /// The branch address.  The event is created by ROOT when an entry is
+    /// read, and is then handed to the caller.
+    CP::TEvent* fEvent;
+
+    /// Serialize the file access when ROOT isn't thread safe.  This is NULL
+    /// when the trees can be read at the same time.
+    static TMutex* fIOMutex;
+};
+#endif
@@ -0,0 +1,203 @@
+#include "TFiducialVolume.hxx"
+
+#include <TCaptLog.hxx>
+#include <HEPUnits.hxx>
+
+#include <TGeoManager.h>
+#include <TGeoNode.h>
+#include <TGeoVolume.h>
+#include <TGeoBBox.h>
+
+#include <algorithm>
+#include <cmath>
+
+CP::TFiducialVolume::TFiducialVolume(const std::string& prefix)
+    : fPrefix(prefix), fGeometry(NULL), fVoxelSize(20*unit::mm),
+      fTolerance(0.01*unit::mm) {
+    for (int i = 0; i < 3; ++i) {
+        fLow[i] = 0.0;
+        fStep[i] = 1.0;
+        fCount[i] = 0;
+    }
+}
+
+void CP::TFiducialVolume::Build(TGeoManager* geom) {
+    if (geom == fGeometry) return;
+    fGeometry = geom;
+    fVolumes.clear();
+    fVoxels.clear();
+    for (int i = 0; i < 3; ++i) fCount[i] = 0;
+    if (!geom || !geom->GetTopVolume()) return;
+
+    // Find the volumes.  The daughters of a volume are inside of it, so
+    // they don't need to be visited.
+    TGeoIterator next(geom->GetTopVolume());
+    TGeoNode* node;
+    while ((node = next())) {
+        if (std::string(node->GetName()).compare(0, fPrefix.size(),
+                                                 fPrefix) != 0) {
+            continue;
+        }
+        next.Skip();
+        fVolumes.push_back(Volume());
+        Volume& volume = fVolumes.back();
+        volume.fMatrix = TGeoHMatrix(*next.GetCurrentMatrix());
+        volume.fShape = node->GetVolume()->GetShape();
+
+        // Find the bounding box in the master frame from the corners of
+        // the local bounding box.
+        const TGeoBBox* box = static_cast<const TGeoBBox*>(volume.fShape);
+        const double* origin = box->GetOrigin();
+        double half[3] = {box->GetDX(), box->GetDY(), box->GetDZ()};
+        for (int corner = 0; corner < 8; ++corner) {
+            double local[3];
+            double master[3];
+            for (int i = 0; i < 3; ++i) {
+                local[i] = origin[i] + ((corner & (1<<i)) ? half[i]: -half[i]);
+            }
+            volume.fMatrix.LocalToMaster(local,master);
+            for (int i = 0; i < 3; ++i) {
+                if (corner == 0 || master[i] < volume.fLow[i]) {
+                    volume.fLow[i] = master[i];
+                }
+                if (corner == 0 || master[i] > volume.fHigh[i]) {
+                    volume.fHigh[i] = master[i];
+                }
+            }
+        }
+    }
+    if (fVolumes.empty()) {
+        CaptError("No volumes named " << fPrefix << "* in the geometry");
+        return;
+    }
+
+    // Cover the volumes with the voxels.
+    double high[3];
+    for (int i = 0; i < 3; ++i) {
+        fLow[i] = fVolumes.front().fLow[i];
+        high[i] = fVolumes.front().fHigh[i];
+        for (std::vector<Volume>::iterator v = fVolumes.begin();
+             v != fVolumes.end(); ++v) {
+            fLow[i] = std::min(fLow[i], v->fLow[i]);
+            high[i] = std::max(high[i], v->fHigh[i]);
+        }
+        double extent = std::max(high[i] - fLow[i], 1*unit::mm);
+        fCount[i] = (int) std::ceil(extent/fVoxelSize);
+        fCount[i] = std::max(1, std::min(fCount[i], 256));
+        fStep[i] = extent/fCount[i];
+    }
+
+    fVoxels.resize(fCount[0]*fCount[1]*fCount[2]);
+    double half[3] = {0.5*fStep[0], 0.5*fStep[1], 0.5*fStep[2]};
+    int surface = 0;
+    std::size_t index = 0;
+    for (int k = 0; k < fCount[2]; ++k) {
+        for (int j = 0; j < fCount[1]; ++j) {
+            for (int i = 0; i < fCount[0]; ++i) {
+                double low[3] = {fLow[0] + i*fStep[0],
+                                 fLow[1] + j*fStep[1],
+                                 fLow[2] + k*fStep[2]};
+                fVoxels[index] = ClassifyVoxel(low, half);
+                if (fVoxels[index] == kSurface) ++surface;
+                ++index;
+            }
+        }
+    }
+
+    CaptLog("Fiducial volume with " << fVolumes.size() << " " << fPrefix
+            << "* volumes in " << fCount[0] << "x" << fCount[1]
+            << "x" << fCount[2] << " voxels (" << surface << " on surface)");
+}
+
+int CP::TFiducialVolume::ClassifyVoxel(const double low[3],
+                                       const double half[3]) const {
+    double center[3];
+    double reach = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        center[i] = low[i] + half[i];
+        reach += half[i]*half[i];
+    }
+    reach = std::sqrt(reach);
+
+    // The safety is the distance to the nearest boundary of the shape (or
+    // an underestimate), so a voxel within the safety of the center is
+    // entirely inside (or outside) the shape.
+    bool surface = false;
+    for (std::vector<Volume>::const_iterator v = fVolumes.begin();
+         v != fVolumes.end(); ++v) {
+        bool overlaps = true;
+        for (int i = 0; i < 3; ++i) {
+            if (low[i] + 2*half[i] < v->fLow[i]) overlaps = false;
+            if (low[i] > v->fHigh[i]) overlaps = false;
+        }
+        if (!overlaps) continue;
+        double local[3];
+        v->fMatrix.MasterToLocal(center,local);
+        bool inside = v->fShape->Contains(local);
+        double safety = v->fShape->Safety(local,inside);
+        if (safety >= reach) {
+            if (inside) return kInside;
+            continue;
+        }
+        surface = true;
+    }
+    if (surface) return kSurface;
+    return kOutside;
+}
+
+bool CP::TFiducialVolume::Contains(double x, double y, double z) const {
+    if (fVoxels.empty()) return false;
+    double master[3] = {x, y, z};
+    std::size_t index = 0;
+    std::size_t stride = 1;
+    for (int i = 0; i < 3; ++i) {
+        double offset = (master[i] - fLow[i])/fStep[i];
+        if (offset < 0.0 || offset >= fCount[i]) return false;
+        index += stride*((std::size_t) offset);
+        stride *= fCount[i];
+    }
+    unsigned char voxel = fVoxels[index];
+    if (voxel == kInside) return true;
+    if (voxel == kOutside) return false;
+    return ContainsExact(master);
+}
+
+bool CP::TFiducialVolume::ContainsExact(const double master[3]) const {
+    for (std::vector<Volume>::const_iterator v = fVolumes.begin();
+         v != fVolumes.end(); ++v) {
+        bool overlaps = true;
+        for (int i = 0; i < 3; ++i) {
+            if (master[i] < v->fLow[i] || master[i] > v->fHigh[i]) {
+                overlaps = false;
+            }
+        }
+        if (!overlaps) continue;
+        double local[3];
+        v->fMatrix.MasterToLocal(master,local);
+        if (v->fShape->Contains(local)) return true;
+    }
+    return false;
+}
+
+void CP::TFiducialVolume::FindBoundary(const double inside[3],
+                                       const double outside[3],
+                                       double boundary[3]) const {
+    double in[3] = {inside[0], inside[1], inside[2]};
+    double out[3] = {outside[0], outside[1], outside[2]};
+    for (int step = 0; step < 40; ++step) {
+        double length2 = 0.0;
+        for (int i = 0; i < 3; ++i) {
+            boundary[i] = 0.5*(in[i] + out[i]);
+            length2 += (out[i]-in[i])*(out[i]-in[i]);
+        }
+        if (length2 < fTolerance*fTolerance) break;
+        if (Contains(boundary[0], boundary[1], boundary[2])) {
+            std::copy(boundary, boundary+3, in);
+        }
+        else {
+            std::copy(boundary, boundary+3, out);
+        }
+    }
+    // Use the last point known to be inside.
+    std::copy(in, in+3, boundary);
+}
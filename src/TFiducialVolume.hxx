@@ -0,0 +1,106 @@
+#ifndef TFiducialVolume_hxx_seen
+#define TFiducialVolume_hxx_seen
+
+#include <TGeoMatrix.h>
+
+#include <vector>
+#include <string>
+
+namespace CP {
+    class TFiducialVolume;
+};
+
+class TGeoManager;
+class TGeoShape;
+
+/// A fast test of whether a point is inside a set of geometry volumes (e.g.
+/// the liquid argon).  The volumes are the nodes whose names start with a
+/// prefix (e.g. "Liquid_"), and a point inside one of their daughters is
+/// inside the volume.  This gives the same answer as finding the node with
+/// the geometry navigator and checking for the prefix in the path, but
+/// doesn't need the navigator.
+///
+/// The bounding box of the volumes is divided into voxels which are
+/// classified once per geometry as inside, outside, or on the surface.  Only
+/// the points in surface voxels are checked against the shapes.  After the
+/// voxels are built, Contains() only reads the object, so it can be called
+/// from several threads at once.
+class CP::TFiducialVolume {
+public:
+    /// Make an empty volume for the nodes with names starting with the
+    /// prefix.  The volume contains nothing until Build() is called.
+    explicit TFiducialVolume(const std::string& prefix);
+
+    /// Find the volumes and fill the voxels for a geometry.  The voxels are
+    /// only rebuilt if the geometry has changed since the last call.  This
+    /// uses the geometry, so it must not be called while the geometry is
+    /// being navigated on another thread.
+    void Build(TGeoManager* geom);
+
+    /// Check if a point (in the master frame) is inside one of the volumes.
+    bool Contains(double x, double y, double z) const;
+
+    /// Find where a step from a point inside the volume to a point outside
+    /// crosses the boundary.  The crossing is found by bisection to within
+    /// the tolerance (0.01 mm by default).
+    void FindBoundary(const double inside[3], const double outside[3],
+                      double boundary[3]) const;
+
+    /// Set the tolerance for the crossings found by FindBoundary().
+    void SetTolerance(double tolerance) {fTolerance = tolerance;}
+
+    /// Set the size of the voxels.  This takes effect at the next Build().
+    void SetVoxelSize(double size) {fVoxelSize = size;}
+
+private:
+
+    /// The classification of a voxel.
+    enum {kOutside = 0, kInside = 1, kSurface = 2};
+
+    /// A volume in the master frame.
+    struct Volume {
+        /// The global matrix of the node.
+        TGeoHMatrix fMatrix;
+
+        /// The shape of the node.
+        const TGeoShape* fShape;
+
+        /// The bounding box of the node in the master frame.
+        double fLow[3];
+        double fHigh[3];
+    };
+
+    /// Check a point against the shapes of the volumes.
+    bool ContainsExact(const double master[3]) const;
+
+    /// Classify the voxel with the low corner and half size.
+    int ClassifyVoxel(const double low[3], const double half[3]) const;
+
+    /// The prefix of the names of the nodes.
+    std::string fPrefix;
+
+    /// The geometry used to build the voxels.
+    TGeoManager* fGeometry;
+
+    /// The size of the voxels.
+    double fVoxelSize;
+
+    /// The tolerance for the boundary crossings.
+    double fTolerance;
+
+    /// The volumes.
+    std::vector<Volume> fVolumes;
+
+    /// The low corner of the voxel grid.
+    double fLow[3];
+
+    /// The size of a voxel along each axis.
+    double fStep[3];
+
+    /// The number of voxels along each axis.
+    int fCount[3];
+
+    /// The classification of each voxel.  The X index changes fastest.
+    std::vector<unsigned char> fVoxels;
+};
+#endif
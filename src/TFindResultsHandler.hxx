@@ -17,6 +17,9 @@ class CP::TFindResultsHandler: public TVEventChangeHandler {
 public:
     TFindResultsHandler();
     ~TFindResultsHandler();
+
+    /// The name of the handler used in timing reports.
+    virtual const char* GetName() const {return "results";}
     
     /// Draw fit information into the current scene.
     virtual void Apply();
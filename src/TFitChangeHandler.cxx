@@ -52,6 +52,25 @@ CP::TFitChangeHandler::TFitChangeHandler() {
 CP::TFitChangeHandler::~TFitChangeHandler() {
 }
 
+void CP::TFitChangeHandler::GetEventPaths(
+    std::vector<std::string>& paths) const {
+    paths.push_back("fits");
+    paths.push_back("hits");
+}
+
+void CP::TFitChangeHandler::GetControls(
+    std::vector<TGFrame*>& controls) const {
+    CP::TGUIManager& gui = CP::TEventDisplay::Get().GUI();
+    controls.push_back(gui.GetShowFitsButton());
+    controls.push_back(gui.GetShowFitsHitsButton());
+    controls.push_back(gui.GetShowFitsDirectionButton());
+    controls.push_back(gui.GetShowConstituentClustersButton());
+    controls.push_back(gui.GetShowClusterHitsButton());
+    controls.push_back(gui.GetShowClusterUncertaintyButton());
+    controls.push_back(gui.GetRecalculateViewButton());
+    controls.push_back(gui.GetResultsList());
+}
+
 void CP::TFitChangeHandler::Apply() {
 
     fHitList->DestroyElements();
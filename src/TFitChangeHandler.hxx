@@ -25,10 +25,19 @@ public:
 
     TFitChangeHandler();
     ~TFitChangeHandler();
+
+    /// The name of the handler used in timing reports.
+    virtual const char* GetName() const {return "fits";}
     
     /// Draw fit information into the current scene.
     virtual void Apply();
 
+    /// Declare the event data used by the handler.
+    virtual void GetEventPaths(std::vector<std::string>& paths) const;
+
+    /// Declare the GUI controls used by the handler.
+    virtual void GetControls(std::vector<TGFrame*>& controls) const;
+
 private:
 
     /// A method to draw a TReconCluster.
@@ -1,6 +1,10 @@
 #include "TG4HitChangeHandler.hxx"
 #include "TEventDisplay.hxx"
 #include "TGUIManager.hxx"
+#include "TEventChangeManager.hxx"
+#include "TEveElementPool.hxx"
+#include "TG4HitLineSet.hxx"
+#include "TDriftVolume.hxx"
 
 #include <TCaptLog.hxx>
 #include <TG4HitSegment.hxx>
@@ -15,48 +19,61 @@
 #include <CaptGeomId.hxx>
 
 #include <TGButton.h>
+#include <TVirtualMutex.h>
+#include <TGeoManager.h>
 
 #include <TEveManager.h>
-#include <TEveLine.h>
 
 #include <sstream>
+#include <map>
 
 CP::TG4HitChangeHandler::TG4HitChangeHandler() {
     fG4HitList = new TEveElementList("g4HitList","Geant4 Truth Hits");
     fG4HitList->SetMainColor(kCyan);
     fG4HitList->SetMainAlpha(1.0);
     gEve->AddElement(fG4HitList);
+    fG4HitPool = new CP::TEveElementPool<CP::TG4HitLineSet>(fG4HitList);
+    fDrift = new CP::TDriftVolume();
+    fPreparedSerial = -1;
+    fBuiltSerial = -1;
+    fShowHits = false;
+    fResolvedSerial = -1;
 }
 
 CP::TG4HitChangeHandler::~TG4HitChangeHandler() {
+    delete fG4HitPool;
+    delete fDrift;
 }
 
-void CP::TG4HitChangeHandler::Apply() {
+void CP::TG4HitChangeHandler::GetEventPaths(
+    std::vector<std::string>& paths) const {
+    paths.push_back("truth/g4Hits");
+    paths.push_back("truth/G4Trajectories");
+}
 
-    fG4HitList->DestroyElements();
+void CP::TG4HitChangeHandler::GetControls(
+    std::vector<TGFrame*>& controls) const {
+    controls.push_back(CP::TEventDisplay::Get().GUI().GetShowG4HitsButton());
+}
 
-    if (!CP::TEventDisplay::Get().GUI().GetShowG4HitsButton()->IsOn()) {
-        CaptLog("G4 hits disabled");
-        return;
-    }
+void CP::TG4HitChangeHandler::Apply() {
+    Resolve();
+    Prepare();
+    Commit();
+}
+
+void CP::TG4HitChangeHandler::Resolve() {
+    fContainers.clear();
+    fShowHits = CP::TEventDisplay::Get().GUI().GetShowG4HitsButton()->IsOn();
+    fResolvedSerial = CP::TEventDisplay::Get().EventChange().GetEventSerial();
+    if (!fShowHits || fBuiltSerial == fResolvedSerial) return;
 
-    CaptLog("Handle the geant4 truth hits");
     CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
     if (!event) return;
 
     CP::THandle<CP::TDataVector> truthHits 
         = event->Get<CP::TDataVector>("truth/g4Hits");
-
-    if (!truthHits) {
-        CaptLog("No truth hits in event");
-        return;
-    }
-
-    CP::THandle<CP::TG4TrajectoryContainer> truthTrajectories
-        = event->Get<CP::TG4TrajectoryContainer>("truth/G4Trajectories");
-
-    double minEnergy = 0.18*unit::MeV/unit::mm;
-    double maxEnergy = 3.0*unit::MeV/unit::mm;
+    if (!truthHits) return;
 
     for (CP::TDataVector::iterator h = truthHits->begin();
          h != truthHits->end();
@@ -68,7 +85,53 @@ void CP::TG4HitChangeHandler::Apply() {
                        << (*h)->GetName());
             continue;
         }
+        fContainers.push_back(&(*g4Hits));
+    }
+}
+
+void CP::TG4HitChangeHandler::Prepare() {
+    fSegments.clear();
+
+    // Only the state saved by Resolve() is used here.
+    if (!fShowHits) return;
+
+    // The hits for this event have already been built, and only need to be
+    // shown again.
+    if (fBuiltSerial == fResolvedSerial) return;
+    fPreparedSerial = -1;
+
+    if (fContainers.empty()) {
+        fPreparedSerial = fResolvedSerial;
+        return;
+    }
+
+    double minEnergy = 0.18*unit::MeV/unit::mm;
+    double maxEnergy = 3.0*unit::MeV/unit::mm;
+
+    // The drift volume is only found again when the geometry changes.
+    {
+        TLockGuard lock(CP::TEventDisplay::Get().EventChange()
+                        .GetGeometryMutex());
+        fDrift->Build(gGeoManager);
+    }
+
+    // Collect the hit segments so that the start points can be classified
+    // in one batch.  The starts are kept in double precision so that the
+    // classification matches the navigator at the drift boundary.
+    std::vector<const CP::TG4HitSegment*> segments;
+    std::vector<double> startX;
+    std::vector<double> startY;
+    std::vector<double> startZ;
+    for (std::vector<const CP::TG4HitContainer*>::iterator c
+             = fContainers.begin();
+         c != fContainers.end();
+         ++c) {
+        // Stop if a newer event has been requested.
+        if (CP::TEventDisplay::Get().EventChange().IsUpdateCancelled()) {
+            return;
+        }
 
+        const CP::TG4HitContainer* g4Hits = *c;
         for (CP::TG4HitContainer::const_iterator h = g4Hits->begin(); 
              h != g4Hits->end();
              ++h) {
@@ -79,69 +142,134 @@ void CP::TG4HitChangeHandler::Apply() {
                 CaptWarn("Not showing TG4Hit not castable as a TG4HitSegment.");
                 continue;
             }
+            segments.push_back(seg);
+            startX.push_back(seg->GetStartX());
+            startY.push_back(seg->GetStartY());
+            startZ.push_back(seg->GetStartZ());
+        }
+    }
+    if (segments.empty()) {
+        fPreparedSerial = fResolvedSerial;
+        return;
+    }
 
-            double energy = seg->GetEnergyDeposit();
-            double length = seg->GetTrackLength();
-            double dEdX = energy;
-            if (length>0.01*unit::mm) dEdX /= length;
+    std::vector<unsigned char> drift(segments.size());
+    fDrift->Classify(segments.size(),
+                     &startX[0], &startY[0], &startZ[0], &drift[0]);
 
+    for (std::size_t s = 0; s < segments.size(); ++s) {
+        if (s%1000 == 999
+            && CP::TEventDisplay::Get().EventChange().IsUpdateCancelled()) {
+            fSegments.clear();
+            return;
+        }
+
+        const CP::TG4HitSegment* seg = segments[s];
+        double energy = seg->GetEnergyDeposit();
+        double length = seg->GetTrackLength();
+        double dEdX = energy;
+        if (length>0.01*unit::mm) dEdX /= length;
+
+        // The navigator is only needed for starts in a daughter of the drift
+        // volume, and for short hits outside of the drift since they are
+        // only plotted if they aren't in the geometry.
+        bool inDrift = (drift[s] == CP::TDriftVolume::kInside);
+        bool validId = true;
+        if (drift[s] == CP::TDriftVolume::kCheck
+            || (!inDrift && length < 2*unit::mm)) {
             TGeometryId id;
-            bool validId 
-                = CP::TManager::Get().GeomId().GetGeometryId(
+            {
+                TLockGuard lock(CP::TEventDisplay::Get().EventChange()
+                                .GetGeometryMutex());
+                validId = CP::TManager::Get().GeomId().GetGeometryId(
                     seg->GetStartX(),seg->GetStartY(),seg->GetStartZ(), id);
+            }
+            inDrift = validId && id==CP::GeomId::Captain::Drift();
+        }
 
-            // If the hit is outside of drift, only plot the long ones.
-            if (validId 
-                && id!=CP::GeomId::Captain::Drift() 
-                && length < 2*unit::mm) continue;
+        // If the hit is outside of drift, only plot the long ones.
+        if (validId && !inDrift && length < 2*unit::mm) continue;
 
-            
-            TEveLine* eveHit = new TEveLine(2);
-            eveHit->SetName((*h)->GetName());
-            std::ostringstream title;
-            title << "G4 Hit";
-            if (truthTrajectories) {
-                int part = seg->GetContributor(0);
-                CP::THandle<CP::TG4Trajectory> traj 
-                    = truthTrajectories->GetTrajectory(part);
-                if (traj) {
-                    title << " " << traj->GetParticleName();
-                    title << " (" << 
-                        unit::AsString(traj->GetInitialMomentum().P(),
-                                       "momentum") << ")";
-                }
-            }
-            title << std::fixed << std::setprecision(2)
-                  << " " << dEdX/(unit::MeV/unit::cm) << " MeV/cm";
-            title << " for " << unit::AsString(length,"length")
-                  << " at (" <<  unit::AsString(seg->GetStartX(), "length")
-                  << "," <<  unit::AsString(seg->GetStartY(), "length")
-                  << "," <<  unit::AsString(seg->GetStartZ(), "length") << ")";
-
-            eveHit->SetTitle(title.str().c_str());
-
-            if (validId && id==CP::GeomId::Captain::Drift()) {
-                eveHit->SetLineColor(TEventDisplay::Get().LogColor(
-                                         dEdX,
-                                         minEnergy,
-                                         maxEnergy,
-                                         3));
-            }
-            else {
-                eveHit->SetLineColor(kCyan);
-            }
+        // The title is only made if the segment is picked.
+        fSegments.push_back(Segment());
+        Segment& segment = fSegments.back();
+        segment.fHit.fLength = length;
+        segment.fHit.fDEdX = dEdX;
+        segment.fHit.fContributor = seg->GetContributor(0);
 
-            eveHit->SetPoint(0,
-                             seg->GetStartX(),
-                             seg->GetStartY(),
-                             seg->GetStartZ());
-            eveHit->SetPoint(1,
-                             seg->GetStopX(),
-                             seg->GetStopY(),
-                             seg->GetStopZ());
-            fG4HitList->AddElement(eveHit);
+        if (inDrift) {
+            segment.fColor = TEventDisplay::Get().LogColor(dEdX,
+                                                           minEnergy,
+                                                           maxEnergy,
+                                                           3);
+        }
+        else {
+            segment.fColor = kCyan;
         }
 
+        segment.fHit.fStart[0] = startX[s];
+        segment.fHit.fStart[1] = startY[s];
+        segment.fHit.fStart[2] = startZ[s];
+        segment.fStop[0] = seg->GetStopX();
+        segment.fStop[1] = seg->GetStopY();
+        segment.fStop[2] = seg->GetStopZ();
     }
+    fPreparedSerial = fResolvedSerial;
+}
 
+void CP::TG4HitChangeHandler::Commit() {
+
+    // Toggling the hits only changes whether they are drawn.  The elements
+    // are kept until a different event is shown.
+    bool show = CP::TEventDisplay::Get().GUI().GetShowG4HitsButton()->IsOn();
+    fG4HitList->SetRnrState(show);
+    if (!show) {
+        CaptLog("G4 hits disabled");
+        return;
+    }
+
+    int serial = CP::TEventDisplay::Get().EventChange().GetEventSerial();
+    if (fBuiltSerial == serial) {
+        CaptLog("Show the geant4 truth hits");
+        return;
+    }
+    if (fPreparedSerial != serial) {
+        // The button was turned on after the update started (or the update
+        // was cancelled), so the hits weren't prepared.  The next update
+        // will draw them.
+        fG4HitPool->Reset();
+        fBuiltSerial = -1;
+        return;
+    }
+    fG4HitPool->Reset();
+    fBuiltSerial = serial;
+
+    CaptLog("Handle the geant4 truth hits");
+    if (fSegments.empty()) {
+        CaptLog("No truth hits in event");
+        return;
+    }
+
+    // The segments are drawn in one line set for each color, so there
+    // are only as many objects to render as there are colors.
+    std::map<int, CP::TG4HitLineSet*> sets;
+    for (std::vector<Segment>::iterator s = fSegments.begin();
+         s != fSegments.end(); ++s) {
+        CP::TG4HitLineSet*& hits = sets[s->fColor];
+        if (!hits) {
+            hits = fG4HitPool->Get();
+            hits->ResetHits();
+            hits->SetLineColor(s->fColor);
+        }
+        hits->AddHit(s->fHit, s->fStop);
+    }
+    for (std::map<int, CP::TG4HitLineSet*>::iterator h = sets.begin();
+         h != sets.end(); ++h) {
+        std::ostringstream title;
+        title << h->second->GetHitCount() << " G4 hits";
+        h->second->SetTitle(title.str().c_str());
+    }
+    CaptLog("Draw " << fSegments.size() << " truth hits in " << sets.size()
+            << " line sets");
+    fSegments.clear();
 }
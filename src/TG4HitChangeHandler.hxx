@@ -2,9 +2,13 @@
 #define TG4HitChangeHandler_hxx_seen
 
 #include "TVEventChangeHandler.hxx"
+#include "TG4HitLineSet.hxx"
 
 namespace CP {
     class TG4HitChangeHandler;
+    template <class T> class TEveElementPool;
+    class TDriftVolume;
+    class TG4HitContainer;
 };
 
 class TEveElementList;
@@ -15,14 +19,76 @@ public:
     TG4HitChangeHandler();
     ~TG4HitChangeHandler();
 
+    /// The name of the handler used in timing reports.
+    virtual const char* GetName() const {return "g4Hits";}
+
+    /// The handler is detailed, so it's drawn after the coarse handlers.
+    virtual int GetDetailLevel() const {return 1;}
+
     /// Draw the trajectories into the current scene.
    virtual void Apply();
 
+    /// The hit segments are found in a worker thread.
+    virtual bool HasPrepare() const {return true;}
+
+    /// Find the hit containers in the event, and save the state of the GUI
+    /// for Prepare().
+    virtual void Resolve();
+
+    /// Find the hit segments to draw.
+    virtual void Prepare();
+
+    /// Create the EVE lines for the hit segments.
+    virtual void Commit();
+
+    /// Declare the event data used by the handler.
+    virtual void GetEventPaths(std::vector<std::string>& paths) const;
+
+    /// Declare the GUI controls used by the handler.
+    virtual void GetControls(std::vector<TGFrame*>& controls) const;
+
 private:
 
     /// The GEANT4 hits to draw in the event.
     TEveElementList* fG4HitList;
 
+    /// The line sets used to draw the hit segments.  They are reused for
+    /// each event.
+    CP::TEveElementPool<CP::TG4HitLineSet>* fG4HitPool;
+
+    /// The drift volume used to choose the color of the hit segments.
+    CP::TDriftVolume* fDrift;
+
+    /// The serial number of the event that the hit segments were prepared
+    /// for, or -1.
+    int fPreparedSerial;
+
+    /// The serial number of the event that the hit segments were built for,
+    /// or -1.
+    int fBuiltSerial;
+
+    /// The display data for a hit segment.
+    struct Segment {
+        /// The information used to describe the segment (and the start).
+        CP::TG4HitLineSet::Hit fHit;
+        int fColor;
+        float fStop[3];
+    };
+
+    /// The state of the "Show G4 Hits" button when Resolve() was called.
+    /// The GUI is still running during Prepare(), so the button isn't read
+    /// by the worker thread.
+    bool fShowHits;
+
+    /// The serial number of the event when Resolve() was called.
+    int fResolvedSerial;
+
+    /// The hit containers found by Resolve().
+    std::vector<const CP::TG4HitContainer*> fContainers;
+
+    /// The hit segments found by Prepare().
+    std::vector<Segment> fSegments;
+
 };
 
 #endif
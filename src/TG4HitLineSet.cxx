@@ -0,0 +1,84 @@
+#include "TG4HitLineSet.hxx"
+#include "TEventDisplay.hxx"
+#include "TEventChangeManager.hxx"
+
+#include <TCaptLog.hxx>
+#include <TG4Trajectory.hxx>
+#include <TEvent.hxx>
+#include <TEventFolder.hxx>
+#include <TUnitsTable.hxx>
+#include <HEPUnits.hxx>
+#include <THandle.hxx>
+
+#include <TGLSelectRecord.h>
+
+#include <sstream>
+#include <iomanip>
+
+ClassImp(CP::TG4HitLineSet);
+ClassImp(CP::TG4HitLineSetGL);
+
+CP::TG4HitLineSet::TG4HitLineSet()
+    : TEveStraightLineSet("g4Hits") {}
+
+CP::TG4HitLineSet::~TG4HitLineSet() {}
+
+void CP::TG4HitLineSet::ResetHits() {
+    fHits.clear();
+    GetLinePlex().Reset(sizeof(TEveStraightLineSet::Line_t), 1024);
+}
+
+void CP::TG4HitLineSet::AddHit(const Hit& hit, const float stop[3]) {
+    // The line id is the index of the hit.
+    AddLine(hit.fStart[0], hit.fStart[1], hit.fStart[2],
+            stop[0], stop[1], stop[2]);
+    fHits.push_back(hit);
+}
+
+std::string CP::TG4HitLineSet::GetHitTitle(int line) const {
+    if (line < 0 || line >= (int) fHits.size()) return "";
+    const Hit& hit = fHits[line];
+
+    std::ostringstream title;
+    title << "G4 Hit";
+    // The trajectory isn't described while an update is running since the
+    // event is being read by the update threads.
+    CP::TEvent* event = NULL;
+    if (!CP::TEventDisplay::Get().EventChange().IsUpdating()) {
+        event = CP::TEventFolder::GetCurrentEvent();
+    }
+    CP::THandle<CP::TG4TrajectoryContainer> truthTrajectories;
+    if (event) {
+        truthTrajectories
+            = event->Get<CP::TG4TrajectoryContainer>("truth/G4Trajectories");
+    }
+    if (truthTrajectories) {
+        CP::THandle<CP::TG4Trajectory> traj
+            = truthTrajectories->GetTrajectory(hit.fContributor);
+        if (traj) {
+            title << " " << traj->GetParticleName();
+            title << " (" <<
+                unit::AsString(traj->GetInitialMomentum().P(),
+                               "momentum") << ")";
+        }
+    }
+    title << std::fixed << std::setprecision(2)
+          << " " << hit.fDEdX/(unit::MeV/unit::cm) << " MeV/cm";
+    title << " for " << unit::AsString(hit.fLength,"length")
+          << " at (" <<  unit::AsString(hit.fStart[0], "length")
+          << "," <<  unit::AsString(hit.fStart[1], "length")
+          << "," <<  unit::AsString(hit.fStart[2], "length") << ")";
+    return title.str();
+}
+
+void CP::TG4HitLineSetGL::ProcessSelection(TGLRnrCtx& rnrCtx,
+                                           TGLSelectRecord& rec) {
+    // The names for a line are the object, one (for a line), and the line
+    // id.
+    if (rec.GetN() != 3 || rec.GetItem(1) != 1) return;
+    CP::TG4HitLineSet* hits = dynamic_cast<CP::TG4HitLineSet*>(fExternalObj);
+    if (!hits) return;
+    std::string title = hits->GetHitTitle(rec.GetItem(2));
+    CaptLog(title);
+    hits->SetTitle(title.c_str());
+}
@@ -0,0 +1,76 @@
+#ifndef TG4HitLineSet_hxx_seen
+#define TG4HitLineSet_hxx_seen
+
+#include <TEveStraightLineSet.h>
+#include <TEveStraightLineSetGL.h>
+
+#include <vector>
+#include <string>
+
+namespace CP {
+    class TG4HitLineSet;
+    class TG4HitLineSetGL;
+};
+
+/// A set of GEANT4 hit segments drawn as one EVE object.  The segments are
+/// lines in the set, and the information needed to describe each segment
+/// is kept next to the line.  The description is only formatted when a
+/// segment is picked (see TG4HitLineSetGL), and then becomes the title of
+/// the set so that it's shown as the tooltip.
+class CP::TG4HitLineSet: public TEveStraightLineSet {
+public:
+    /// The information used to describe a hit segment.
+    struct Hit {
+        /// The start of the segment.
+        float fStart[3];
+
+        /// The length of the segment.
+        float fLength;
+
+        /// The energy deposit per length.
+        float fDEdX;
+
+        /// The track id of the main contributor to the hit.
+        int fContributor;
+    };
+
+    TG4HitLineSet();
+    virtual ~TG4HitLineSet();
+
+    /// Remove all of the segments so that the set can be refilled.
+    void ResetHits();
+
+    /// Add a segment from the start of the hit to the stop point.
+    void AddHit(const Hit& hit, const float stop[3]);
+
+    /// Get the number of segments.
+    int GetHitCount() const {return fHits.size();}
+
+    /// Make the description of a segment.  The particle is found in the
+    /// trajectories of the current event.
+    std::string GetHitTitle(int line) const;
+
+private:
+
+    /// The segments in the order the lines were added.
+    std::vector<Hit> fHits;
+
+    ClassDef(TG4HitLineSet,0);
+};
+
+/// The GL renderer for a TG4HitLineSet.  The lines are always picked
+/// individually, and the picked line becomes the title of the set.
+class CP::TG4HitLineSetGL: public TEveStraightLineSetGL {
+public:
+    TG4HitLineSetGL() {}
+    virtual ~TG4HitLineSetGL() {}
+
+    /// Always pick the individual segments.
+    virtual Bool_t AlwaysSecondarySelect() const {return kTRUE;}
+
+    /// Describe the segment that was picked.
+    virtual void ProcessSelection(TGLRnrCtx& rnrCtx, TGLSelectRecord& rec);
+
+    ClassDef(TG4HitLineSetGL,0);
+};
+#endif
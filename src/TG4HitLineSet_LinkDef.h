@@ -0,0 +1,4 @@
+#ifdef __CINT__
+#pragma link C++ class CP::TG4HitLineSet+;
+#pragma link C++ class CP::TG4HitLineSetGL+;
+#endif
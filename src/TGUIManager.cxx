@@ -6,7 +6,6 @@
 #include <TGListBox.h>
 #include <TGLabel.h>
 #include <TGTextEntry.h>
-#include <TGNumberEntry.h>
 
 #include <TEveManager.h>
 #include <TEveBrowser.h>
@@ -62,16 +61,35 @@ void CP::TGUIManager::MakeControlTab() {
     fNextEventButton = textButton;
 
     TGGroupFrame *fGframe = new TGGroupFrame(hf, "Event Number");
-    TGNumberEntry * inputEvent = new TGNumberEntry(fGframe, 0, 9,999,
-                                                  TGNumberFormat::kNESInteger,
-                                                  TGNumberFormat::kNEANonNegative,
-                                                  TGNumberFormat::kNELLimitMinMax,
-                                                  0, 99999);
+    TGTextEntry* inputEvent = new TGTextEntry(fGframe);
+    inputEvent->SetToolTipText(
+        "Enter the event number in the file (counting from one),\n"
+        "or the run and event number as \"run.event\".");
     fGframe->AddFrame(inputEvent,layoutHints);
     //hf->AddFrame(inputEvent, layoutHints);
     hf->AddFrame(fGframe, layoutHints);
     fInputEvent = inputEvent;
 
+    TGGroupFrame* searchFrame = new TGGroupFrame(hf, "Find Next Event");
+    TGTextEntry* searchField = new TGTextEntry(searchFrame);
+    searchField->SetText("drift > 1000");
+    searchField->SetToolTipText(
+        "Enter the condition for the next event to show:\n"
+        "    drift > N      -- More than N drift hits\n"
+        "    pmt > Q        -- A PMT hit with more than Q charge\n"
+        "    container NAME -- Has the named recon container");
+    searchFrame->AddFrame(searchField, layoutHints);
+    fSearchField = searchField;
+
+    textButton = new TGTextButton(searchFrame, "Find Next");
+    textButton->SetToolTipText("Search forward for a matching event.");
+    textButton->SetTextJustify(36);
+    textButton->SetMargins(0,0,0,0);
+    textButton->SetWrapLength(-1);
+    searchFrame->AddFrame(textButton, layoutHints);
+    fSearchButton = textButton;
+    hf->AddFrame(searchFrame, layoutHints);
+
     // Create the buttons to select which types of objects are showed.
     TGCheckButton *checkButton;
 
@@ -143,6 +161,18 @@ void CP::TGUIManager::MakeControlTab() {
     hf->AddFrame(checkButton, layoutHints);
     fShowTrajectoriesButton = checkButton;
 
+    TGGroupFrame* filterFrame = new TGGroupFrame(hf, "Trajectory Filter");
+    TGTextEntry* filterField = new TGTextEntry(filterFrame);
+    filterField->SetToolTipText(
+        "Select the trajectories to show (separate conditions with \";\"):\n"
+        "    momentum > P    -- Initial momentum over P MeV\n"
+        "    depth < N       -- Fewer than N ancestors (primaries are 0)\n"
+        "    pdg = C ...     -- Only these PDG codes\n"
+        "    pdg != C ...    -- Not these PDG codes");
+    filterFrame->AddFrame(filterField, layoutHints);
+    hf->AddFrame(filterFrame, layoutHints);
+    fTrajectoryFilterField = filterField;
+
     checkButton = new TGCheckButton(hf,"Show G4 Hits");
     checkButton->SetToolTipText(
         "Show the GEANT4 hits.  This shows the energy deposition in the "
@@ -294,6 +324,15 @@ void CP::TGUIManager::MakeControlTab() {
     checkButton->SetWrapLength(-1);
     hf->AddFrame(checkButton, layoutHints);
     fShowDigitSamplesButton = checkButton;
+
+    textButton = new TGTextButton(hf, "Print Timing");
+    textButton->SetToolTipText(
+        "Print the time spent reading and drawing events (enable with -t).");
+    textButton->SetTextJustify(36);
+    textButton->SetMargins(0,0,0,0);
+    textButton->SetWrapLength(-1);
+    hf->AddFrame(textButton, layoutHints);
+    fPrintTimingButton = textButton;
     
     // Do the final layout and mapping.
     mainFrame->AddFrame(hf, layoutHints);
@@ -4,7 +4,6 @@
 #include <TGButton.h>
 #include <TGListBox.h>
 #include <TGTextEntry.h>
-#include <TGNumberEntry.h>
 
 namespace CP {
     class TGUIManager;
@@ -42,8 +41,20 @@ public:
     /// Get the previous event button widget.
     TGButton* GetPrevEventButton() {return fPrevEventButton;}
 
-    // Get specific event
-    TGNumberEntry* GetEventField() {return fInputEvent;}
+    /// Get the text entry used to select a specific event.  The text is
+    /// either an event number in the file (counting from one), or a run and
+    /// event number written as "run.event".
+    TGTextEntry* GetEventField() {return fInputEvent;}
+
+    /// Get the text entry with the condition used to search for the next
+    /// matching event.
+    TGTextEntry* GetSearchField() {return fSearchField;}
+
+    /// Get the button to search for the next matching event.
+    TGButton* GetSearchButton() {return fSearchButton;}
+
+    /// Get the button to print the timing report.
+    TGButton* GetPrintTimingButton() {return fPrintTimingButton;}
 
     /// Get the check button selecting if reconstruction objects are shown.
     TGButton* GetShowFitsButton() {return fShowFitsButton;}
@@ -71,6 +82,10 @@ public:
     /// Get the check button selecting if trajectories should be shown.
     TGButton* GetShowTrajectoriesButton() {return fShowTrajectoriesButton;}
 
+    /// Get the text entry with the selection of the trajectories to show
+    /// (e.g. "momentum > 10; depth < 3").
+    TGTextEntry* GetTrajectoryFilterField() {return fTrajectoryFilterField;}
+
     /// Get the check button selecting if G4 hits should be shown.
     TGButton* GetShowG4HitsButton() {return fShowG4HitsButton;}
 
@@ -148,6 +163,7 @@ private:
     TGButton* fShowClusterHitsButton;
     TGButton* fShowClusterUncertaintyButton;
     TGButton* fShowTrajectoriesButton;
+    TGTextEntry* fTrajectoryFilterField;
     TGButton* fShowG4HitsButton;
     TGButton* fRecalculateViewButton;
     TGButton* fDrawHitButton;
@@ -164,7 +180,10 @@ private:
     TGButton* fShowDeconvDigitsButton;
     TGButton* fShowFullDigitsButton;
     TGButton* fShowDigitSamplesButton;
-    TGNumberEntry* fInputEvent;
+    TGTextEntry* fInputEvent;
+    TGTextEntry* fSearchField;
+    TGButton* fSearchButton;
+    TGButton* fPrintTimingButton;
 
     /// Make a tab in the browser to select algorithms shown.
     void MakeResultsTab();
@@ -2,6 +2,8 @@
 #include "TEventDisplay.hxx"
 #include "TGUIManager.hxx"
 #include "TShowPMTHits.hxx"
+#include "TEveElementPool.hxx"
+#include "TEventChangeManager.hxx"
 
 #include <TCaptLog.hxx>
 #include <TEvent.hxx>
@@ -27,6 +29,7 @@
 #include <TEveManager.h>
 #include <TEveGeoShape.h>
 #include <TEveLine.h>
+#include <TEveBoxSet.h>
 #include <TEveRGBAPalette.h>
 
 #include <sstream>
@@ -37,35 +40,84 @@ CP::TPMTChangeHandler::TPMTChangeHandler() {
     fPMTList->SetMainColor(kGreen);
     fPMTList->SetMainAlpha(0.5);
     gEve->AddElement(fPMTList);
+    fPMTPool = new CP::TEveElementPool<TEveBoxSet>(fPMTList);
+    fBuiltSerial = -1;
 
     fPalette = new TEveRGBAPalette(0,15,true,true,false);
 
 }
 
-CP::TPMTChangeHandler::~TPMTChangeHandler() {}
-
-void CP::TPMTChangeHandler::Apply() {
+CP::TPMTChangeHandler::~TPMTChangeHandler() {
+    delete fPMTPool;
+}
 
-    fPMTList->DestroyElements();
+void CP::TPMTChangeHandler::GetEventPaths(
+    std::vector<std::string>& paths) const {
+    paths.push_back("hits/pmt");
+}
 
+void CP::TPMTChangeHandler::GetControls(
+    std::vector<TGFrame*>& controls) const {
 #ifdef USE_GUI_PMTS
-    if (!CP::TEventDisplay::Get().GUI().GetShowPMTsButton()->IsOn()) {
-        CaptLog("PMTs display disabled");
-        return;
-    }
+    controls.push_back(CP::TEventDisplay::Get().GUI().GetShowPMTsButton());
 #endif
+}
+
+void CP::TPMTChangeHandler::Apply() {
+    Resolve();
+    Prepare();
+    Commit();
+}
+
+void CP::TPMTChangeHandler::Resolve() {
+    fPMTName.clear();
+    fPMTs.clear();
+
+    // The hits for this event have already been built.
+    if (fBuiltSerial == CP::TEventDisplay::Get().EventChange()
+        .GetEventSerial()) return;
 
-    CaptLog("Handle the PMT information");
     CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
     if (!event) return;
 
+    // The hit positions come from the geometry, so they are found here on
+    // the GUI thread, and Prepare() only gets the copied data.
     CP::THandle<CP::THitSelection> pmts
         = event->Get<CP::THitSelection>("~/hits/pmt");
     if (!pmts) return;
+    fPMTName = pmts->GetName();
+    CP::TShowPMTHits::FindPMTs(*pmts, fPMTs);
+}
+
+void CP::TPMTChangeHandler::Prepare() {
+    fPMTBoxes.clear();
+    CP::TShowPMTHits::FindBoxes(fPMTs, fPMTBoxes);
+}
+
+void CP::TPMTChangeHandler::Commit() {
+
+    // Toggling the PMTs only changes whether they are drawn.  The box set
+    // is kept until a different event is shown.
+    bool show = true;
+#ifdef USE_GUI_PMTS
+    show = CP::TEventDisplay::Get().GUI().GetShowPMTsButton()->IsOn();
+#endif
+    fPMTList->SetRnrState(show);
+    if (!show) {
+        CaptLog("PMTs display disabled");
+        return;
+    }
+
+    int serial = CP::TEventDisplay::Get().EventChange().GetEventSerial();
+    if (fBuiltSerial == serial) return;
+    fPMTPool->Reset();
+    fBuiltSerial = serial;
+
+    CaptLog("Handle the PMT information");
+    if (fPMTName.empty()) return;
 
     // Draw the hits.
     CP::TShowPMTHits showPMTs(fPalette);
-    showPMTs(fPMTList, *pmts);
-
+    showPMTs.FillBoxSet(fPMTPool->Get(), fPMTName, fPMTBoxes);
+    fPMTBoxes.clear();
 }
-
@@ -2,12 +2,15 @@
 #define TPMTChangeHandler_hxx_seen
 
 #include "TVEventChangeHandler.hxx"
+#include "TShowPMTHits.hxx"
 
 namespace CP {
     class TPMTChangeHandler;
+    template <class T> class TEveElementPool;
 };
 
 class TEveElementList;
+class TEveBoxSet;
 class TEveRGBAPalette;
 
 /// Handle drawing the TAlgorithmResults saved in the event.
@@ -16,18 +19,55 @@ public:
 
     TPMTChangeHandler();
     ~TPMTChangeHandler();
+
+    /// The name of the handler used in timing reports.
+    virtual const char* GetName() const {return "pmts";}
     
     /// Draw fit information into the current scene.
     virtual void Apply();
 
+    /// The boxes are found in a worker thread.
+    virtual bool HasPrepare() const {return true;}
+
+    /// Find the PMT hits in the event, and copy out the data for each PMT.
+    virtual void Resolve();
+
+    /// Find the boxes to draw for the PMT hits.
+    virtual void Prepare();
+
+    /// Create the EVE box set for the PMT hits.
+    virtual void Commit();
+
+    /// Declare the event data used by the handler.
+    virtual void GetEventPaths(std::vector<std::string>& paths) const;
+
+    /// Declare the GUI controls used by the handler.
+    virtual void GetControls(std::vector<TGFrame*>& controls) const;
+
 private:
 
     /// The hits to draw in the event.
     TEveElementList* fPMTList;
 
+    /// The box set used to draw the hits.  It's reused for each event.
+    CP::TEveElementPool<TEveBoxSet>* fPMTPool;
+
+    /// The serial number of the event that the box set was built for, or
+    /// -1.
+    int fBuiltSerial;
+
     /// The palette to draw with.
     TEveRGBAPalette* fPalette;
 
+    /// The name of the PMT hit selection found by Resolve().
+    std::string fPMTName;
+
+    /// The PMT data copied out of the event by Resolve().
+    CP::TShowPMTHits::PMTs fPMTs;
+
+    /// The boxes for the PMT hits found by Prepare().
+    CP::TShowPMTHits::Boxes fPMTBoxes;
+
     /// A boolean to flag if hits should be drawn.
     bool fShowPMTsHits;
 };
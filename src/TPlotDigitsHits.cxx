@@ -1,6 +1,11 @@
 #include "TPlotDigitsHits.hxx"
 #include "TEventDisplay.hxx"
 #include "TGUIManager.hxx"
+#include "TEventChangeManager.hxx"
+#include "TDisplayTimer.hxx"
+#include "TDigitIndex.hxx"
+#include "TChannelTable.hxx"
+#include "TSampleQuantiles.hxx"
 
 #include <HEPUnits.hxx>
 #include <TCaptLog.hxx>
@@ -20,6 +25,7 @@
 #include <TCanvas.h>
 #include <TPad.h>
 #include <TH2F.h>
+#include <TAxis.h>
 #include <TColor.h>
 #include <TPolyLine.h>
 #include <TMarker.h>
@@ -32,64 +38,65 @@
 #include <sstream>
 
 namespace {
-    double GetDigitFirstTime(const CP::TDigit* d) {
-        const CP::TPulseDigit* pulse 
-            = dynamic_cast<const CP::TPulseDigit*>(d);
-        if (pulse) return pulse->GetFirstSample();
-        const CP::TCalibPulseDigit* calib 
-            = dynamic_cast<const CP::TCalibPulseDigit*>(d);
-        if (calib) return calib->GetFirstSample()/unit::microsecond;
-        return 0.0;
-    }
-
-    double GetDigitLastTime(const CP::TDigit* d) {
-        const CP::TPulseDigit* pulse 
-            = dynamic_cast<const CP::TPulseDigit*>(d);
-        if (pulse) return pulse->GetFirstSample()+pulse->GetSampleCount();
-        const CP::TCalibPulseDigit* calib 
-            = dynamic_cast<const CP::TCalibPulseDigit*>(d);
-        if (calib) return calib->GetLastSample()/unit::microsecond;
-        return 0.0;
-    }
-
-    std::size_t GetDigitSampleCount(const CP::TDigit* d) {
-        const CP::TPulseDigit* pulse 
-            = dynamic_cast<const CP::TPulseDigit*>(d);
-        if (pulse) return pulse->GetSampleCount();
-        const CP::TCalibPulseDigit* calib 
-            = dynamic_cast<const CP::TCalibPulseDigit*>(d);
-        if (calib) return calib->GetSampleCount();
-        return 0;
-    }
-
     // This will be 3200 for raw digits and 0 for calibrated digits.
-    double GetDigitTriggerOffset(const CP::TDigit* d) {
-        const CP::TPulseDigit* pulse 
-            = dynamic_cast<const CP::TPulseDigit*>(d);
-        if (!pulse) return 0.0;
-        CP::TChannelCalib chanCalib;
-        double off = chanCalib.GetTimeConstant(pulse->GetChannelId(),0);
-        double tim = chanCalib.GetTimeConstant(pulse->GetChannelId(),1);
-        return - off/tim;
+    double GetDigitTriggerOffset(const CP::TDigitIndex::Digit& d) {
+        if (!d.fPulse) return 0.0;
+        return - d.fTimeOffset/d.fTimeStep;
     }
 
-    // This will be 1 for raw digits and 500ns for calibrated digits.
-    double GetDigitSampleStep(const CP::TDigit* d) {
-        double diff = GetDigitLastTime(d) - GetDigitFirstTime(d);
-        return diff/GetDigitSampleCount(d);
-    }
-
-    double GetDigitSample(const CP::TDigit* d, int i) {
-        const CP::TPulseDigit* pulse 
-            = dynamic_cast<const CP::TPulseDigit*>(d);
-        if (pulse) return pulse->GetSample(i);
-        const CP::TCalibPulseDigit* calib 
-            = dynamic_cast<const CP::TCalibPulseDigit*>(d);
-        if (calib) return calib->GetSample(i);
-        return 0;
-    }
-
-
+    // The sample kernels are applied to each digit with
+    // TDigitIndex::Digit::Apply() so the loops over the samples are
+    // specialized for the type of digit.
+
+    // Add the finite samples to the quantiles.
+    struct QuantileKernel {
+        explicit QuantileKernel(CP::TSampleQuantiles& q) : fQuantiles(q) {}
+        template <class T> void operator () (const T& digit) {
+            std::size_t n = digit.GetSampleCount();
+            for (std::size_t i = 0; i < n; ++i) {
+                double s = digit.GetSample(i);
+                if (!std::isfinite(s)) continue;
+                fQuantiles.Fill(s);
+            }
+        }
+        CP::TSampleQuantiles& fQuantiles;
+    };
+
+    // Find the largest (finite) distance of a sample from the median.
+    struct MaxSignalKernel {
+        explicit MaxSignalKernel(double median)
+            : fMedian(median), fMaxSignal(0.0) {}
+        template <class T> void operator () (const T& digit) {
+            std::size_t n = digit.GetSampleCount();
+            double maxSignal = 0.0;
+            for (std::size_t i = 0; i < n; ++i) {
+                double s = std::abs(digit.GetSample(i) - fMedian);
+                if (!std::isfinite(s)) continue;
+                if (maxSignal < s) maxSignal = s;
+            }
+            fMaxSignal = maxSignal;
+        }
+        double fMedian;
+        double fMaxSignal;
+    };
+
+    // Copy the samples less the median into a buffer.  The loop has no
+    // branches so it can be vectorized.
+    struct ShiftKernel {
+        ShiftKernel(double median, std::vector<double>& values)
+            : fMedian(median), fValues(values) {}
+        template <class T> void operator () (const T& digit) {
+            std::size_t n = digit.GetSampleCount();
+            fValues.resize(n);
+            double* values = n ? &fValues[0] : NULL;
+            const double median = fMedian;
+            for (std::size_t i = 0; i < n; ++i) {
+                values[i] = digit.GetSample(i) - median;
+            }
+        }
+        double fMedian;
+        std::vector<double>& fValues;
+    };
 };
 
 CP::TPlotDigitsHits::TPlotDigitsHits()
@@ -99,47 +106,76 @@ CP::TPlotDigitsHits::TPlotDigitsHits()
 
 CP::TPlotDigitsHits::~TPlotDigitsHits() {}
 
+void CP::TPlotDigitsHits::GetEventPaths(
+    std::vector<std::string>& paths) const {
+    paths.push_back("~/digits/drift");
+    paths.push_back("~/digits/drift-deconv");
+    paths.push_back("~/digits/drift-correl");
+    paths.push_back("~/digits/drift-calib");
+    paths.push_back("~/hits/drift");
+    paths.push_back("~/hits/pmt");
+}
+
 void CP::TPlotDigitsHits::DrawDigits(int plane) {
+    if (CP::TEventDisplay::Get().EventChange().IsUpdating()) {
+        CaptError("Event update in progress");
+        return;
+    }
+    CP::TDisplayTimer timer("plot", "DrawDigits");
+    // Make sure the data used by the plot has been read.
+    CP::TDisplayTimer loadTimer("digits load");
+    std::vector<std::string> paths;
+    GetEventPaths(paths);
+    CP::TEventDisplay::Get().EventChange().LoadEventPaths(paths);
+    loadTimer.Stop();
+
     CP::TChannelCalib chanCalib;
     double wireTimeStep = -1.0;
 
     CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
 
     // Get the default digits to be drawn.
+    std::string driftPath = "~/digits/drift";
     CP::THandle<CP::TDigitContainer> drift
-        = event->Get<CP::TDigitContainer>("~/digits/drift");
+        = event->Get<CP::TDigitContainer>(driftPath.c_str());
 
     // Check if the user wanted to see deconvolved digits.  Raw digits are
     // used if the deconvonvolved digits aren't found.
     bool samplesInTime = false;
     if (CP::TEventDisplay::Get().GUI().GetShowDeconvDigitsButton()->IsOn()
         or !drift) {
+        std::string path = "~/digits/drift-deconv";
         CP::THandle<CP::TDigitContainer> tmp
-            = event->Get<CP::TDigitContainer>("~/digits/drift-deconv");
+            = event->Get<CP::TDigitContainer>(path.c_str());
         // If deconvolved digits are found, then use them.
         if (tmp) {
             samplesInTime = true;
             drift = tmp;
+            driftPath = path;
         } 
     }
     if (CP::TEventDisplay::Get().GUI().GetShowDecorrelDigitsButton()->IsOn()
         or !drift) {
+        std::string path = "~/digits/drift-correl";
         CP::THandle<CP::TDigitContainer> tmp
-            = event->Get<CP::TDigitContainer>("~/digits/drift-correl");
+            = event->Get<CP::TDigitContainer>(path.c_str());
         // If decorrelated digits are found, then use them.
         if (tmp) {
             samplesInTime = true;
             drift = tmp;
+            driftPath = path;
         } 
     }
     if (CP::TEventDisplay::Get().GUI().GetShowCalibDigitsButton()->IsOn()
         or !drift) {
+        std::string path = "~/digits/drift-calib";
         CP::THandle<CP::TDigitContainer> tmp
-            = event->Get<CP::TDigitContainer>("~/digits/drift-calib");
+            = event->Get<CP::TDigitContainer>(path.c_str());
         // If calib digits are found, then use them.
         if (tmp) {
             samplesInTime = true;
             drift = tmp;
+            driftPath = path;
         } 
     }
     
@@ -184,6 +220,7 @@ void CP::TPlotDigitsHits::DrawDigits(int plane) {
     ///////////////////////////////////////////////////////////////////
     // Find the histogram range (in x and y).
     ///////////////////////////////////////////////////////////////////
+    CP::TDisplayTimer rangeTimer("digits range");
     
     // True if the sample values should be filled into the histogram (slow)
     bool showDigitSamples = true;
@@ -191,7 +228,15 @@ void CP::TPlotDigitsHits::DrawDigits(int plane) {
         showDigitSamples = false;
     }
 
-    if (!drift) {
+    // The digits in each plane are found once per event, and shared by the
+    // plots of all of the planes.
+    const CP::TDigitIndex* digits = NULL;
+    if (drift) {
+        digits = CP::TEventDisplay::Get().EventChange()
+            .GetDigitIndex(driftPath);
+    }
+
+    if (!digits) {
         CaptLog("No drift signals for this event"); 
         showDigitSamples = false;
     }
@@ -204,46 +249,33 @@ void CP::TPlotDigitsHits::DrawDigits(int plane) {
 
     // Find the Z axis range for the histogram.  The median samples the
     // middle.  The max and min are the "biggest" distance from the median.
-    std::vector<double> samples;
+    CP::TSampleQuantiles samples;
     double medianSample = 0.0;
-    if (drift) {
-        for (CP::TDigitContainer::const_iterator d = drift->begin();
-             d != drift->end(); ++d) {
-            // Figure out if this is in the right plane, and get the wire
-            // number.
-            const CP::TDigit* digit 
-                = dynamic_cast<const CP::TDigit*>(*d);
-            if (!digit) continue;
-            CP::TGeometryId id 
-                = CP::TChannelInfo::Get().GetGeometry(digit->GetChannelId());
-            if (CP::GeomId::Captain::GetWirePlane(id) != plane) continue;
-            if (!chanCalib.IsGoodWire(id)) continue;
+    if (digits) {
+        QuantileKernel quantiles(samples);
+        const std::vector<CP::TDigitIndex::Digit>& wires
+            = digits->GetPlane(plane);
+        for (std::vector<CP::TDigitIndex::Digit>::const_iterator d
+                 = wires.begin(); d != wires.end(); ++d) {
+            if (!d->fGood) continue;
             // Save the sample to find the median.
-            for (std::size_t i = 0; i < GetDigitSampleCount(*d); ++i) {
-                double s = GetDigitSample(*d,i);
-                if (!std::isfinite(s)) continue;
-                samples.push_back(s);
-            }
+            d->Apply(quantiles);
             if (digitSampleStep < 0) {
                 // Find the time range.
-                digitSampleStep = GetDigitSampleStep(*d);
+                digitSampleStep = d->GetSampleStep();
                 digitSampleOffset = GetDigitTriggerOffset(*d);
             }
-            if (wireTimeStep < 0.0) {
-                wireTimeStep=chanCalib.GetTimeConstant(
-                    (*d)->GetChannelId(),1);
-            }
+            if (wireTimeStep < 0.0) wireTimeStep = d->fTimeStep;
         }
         
         // Crash prevention.  It shouldn't be possible to have digits without
         // any samples, but...
-        if (samples.empty()) return;
+        if (samples.GetCount() < 1) return;
         
-        std::sort(samples.begin(),samples.end());
-        medianSample = samples[0.5*samples.size()];
+        medianSample = samples.Quantile(0.5);
 
-        double maxSample = std::abs(samples[0.99*samples.size()]-medianSample);
-        double s = std::abs(samples[0.01*samples.size()]-medianSample);
+        double maxSample = std::abs(samples.Quantile(0.99)-medianSample);
+        double s = std::abs(samples.Quantile(0.01)-medianSample);
         maxSample = std::max(maxSample,s);
         
         // Find the time axis range based on the times of the bins with a
@@ -252,26 +284,14 @@ void CP::TPlotDigitsHits::DrawDigits(int plane) {
         // usec to 3197 usec), but things get a little more complicated for the
         // MC.
         std::vector<double> times;
-        for (CP::TDigitContainer::const_iterator d = drift->begin();
-             d != drift->end(); ++d) {
-            // Figure out if this is in the right plane, and get the wire
-            // number.
-            const CP::TDigit* digit 
-                = dynamic_cast<const CP::TDigit*>(*d);
-            if (!digit) continue;
-            CP::TGeometryId id 
-                = CP::TChannelInfo::Get().GetGeometry(digit->GetChannelId());
-            if (CP::GeomId::Captain::GetWirePlane(id) != plane) continue;
-            if (!chanCalib.IsGoodWire(id)) continue;
-            double maxSignal = 0.0;
-            for (std::size_t i = 0; i < GetDigitSampleCount(*d); ++i) {
-                double s = std::abs(GetDigitSample(*d,i) - medianSample);
-                if (!std::isfinite(s)) continue;
-                if (maxSignal < s) maxSignal = s;
-            }
-            if (maxSignal < 0.25*maxSample) continue;
-            times.push_back(GetDigitFirstTime(*d));
-            times.push_back(GetDigitLastTime(*d));
+        for (std::vector<CP::TDigitIndex::Digit>::const_iterator d
+                 = wires.begin(); d != wires.end(); ++d) {
+            if (!d->fGood) continue;
+            MaxSignalKernel signal(medianSample);
+            d->Apply(signal);
+            if (signal.fMaxSignal < 0.25*maxSample) continue;
+            times.push_back(d->GetFirstTime());
+            times.push_back(d->GetLastTime());
         }
         std::sort(times.begin(),times.end());
     
@@ -288,7 +308,10 @@ void CP::TPlotDigitsHits::DrawDigits(int plane) {
             if (signalEnd<(*h)->GetTime()) signalEnd = (*h)->GetTime();
             TChannelId cid = (*h)->GetChannelId();
             if (wireTimeStep < 0) {
-                wireTimeStep = chanCalib.GetTimeConstant(cid,1);
+                const CP::TChannelTable::Channel* channel
+                    = CP::TChannelTable::Get().Find(cid);
+                if (channel) wireTimeStep = channel->fTimeStep;
+                else wireTimeStep = chanCalib.GetTimeConstant(cid,1);
             }
         }
         signalBins = 10000;
@@ -401,33 +424,37 @@ void CP::TPlotDigitsHits::DrawDigits(int plane) {
         break;
     }    
 
+    rangeTimer.Stop();
+
     // Draw the empty histogram to get the panel initialized.
+    CP::TDisplayTimer fillTimer("digits fill");
     digitPlot->SetStats(false);
     digitPlot->Draw("");
     gPad->Update();
 
     // Fill the histogram.
     double maxVal = 10;
-    if (drift) {
-        for (CP::TDigitContainer::const_iterator d = drift->begin();
-             d != drift->end(); ++d) {
-            // Figure out if this is in the right plane, and get the wire
-            // number.
-            const CP::TDigit* digit 
-                = dynamic_cast<const CP::TDigit*>(*d);
-            if (!digit) continue;
-            CP::TGeometryId id 
-                = CP::TChannelInfo::Get().GetGeometry(digit->GetChannelId());
-            if (CP::GeomId::Captain::GetWirePlane(id) != plane) continue;
-            // Plot the digits for this channel.
-            if (!showDigitSamples) continue;
-            double wire = CP::GeomId::Captain::GetWireNumber(id) + 0.5;
-            for (std::size_t i = 0; i < GetDigitSampleCount(digit); ++i) {
-                double tbin = GetDigitFirstTime(digit) 
-                    + GetDigitSampleStep(digit)*i;
-                double sample = GetDigitSample(digit,i)-medianSample;
+    if (digits && showDigitSamples) {
+        const std::vector<CP::TDigitIndex::Digit>& wires
+            = digits->GetPlane(plane);
+        std::vector<double> values;
+        ShiftKernel shift(medianSample, values);
+        TAxis* timeAxis = digitPlot->GetYaxis();
+        for (std::vector<CP::TDigitIndex::Digit>::const_iterator d
+                 = wires.begin(); d != wires.end(); ++d) {
+            // Plot the digits for this channel.  The wire bin is the same
+            // for all of the samples.
+            values.clear();
+            d->Apply(shift);
+            int wireBin = digitPlot->GetXaxis()->FindFixBin(d->fWire + 0.5);
+            double firstTime = d->GetFirstTime();
+            double sampleStep = d->GetSampleStep();
+            for (std::size_t i = 0; i < values.size(); ++i) {
+                double tbin = firstTime + sampleStep*i;
+                double sample = values[i];
                 if (!std::isfinite(sample)) continue;
-                int bin = digitPlot->FindFixBin(wire,tbin+1E-6);
+                int bin = digitPlot->GetBin(wireBin,
+                                            timeAxis->FindFixBin(tbin+1E-6));
                 double val = digitPlot->GetBinContent(bin);
                 if (samplesInTime) { 
                     // Samples in time mean that the calibrated (and
@@ -473,10 +500,14 @@ void CP::TPlotDigitsHits::DrawDigits(int plane) {
     maxVal = std::max(5.0*maxRMS,5.0);
 #endif
     
+    fillTimer.Stop();
+
+    CP::TDisplayTimer drawTimer("digits draw");
     digitPlot->SetMinimum(-maxVal);
     digitPlot->SetMaximum(maxVal+1);
     digitPlot->SetContour(100);
     digitPlot->Draw("colz");
+    drawTimer.Stop();
 
     ////////////////////////////////////////////////////////////
     // Now plot the PMT and TPC hit times on the histogram.
@@ -485,8 +516,10 @@ void CP::TPlotDigitsHits::DrawDigits(int plane) {
     // The number of nanoseconds per unit on the digit histogram.
     double timeUnit =  wireTimeStep/digitSampleStep;
     
+    CP::TDisplayTimer hitsTimer("digits hits");
     DrawPMTHits(timeUnit, digitSampleOffset);
     DrawTPCHits(plane, timeUnit, digitSampleOffset);
+    hitsTimer.Stop();
 
     gPad->Update();
 }
@@ -1,6 +1,7 @@
 #ifndef TPlotDigitsHits_hxx_seen
 #define TPlotDigitsHits_hxx_seen
 #include <vector>
+#include <string>
 
 namespace CP {
     class TPlotDigitsHits;
@@ -21,6 +22,9 @@ public:
     /// separate canvas.
     void DrawDigits(int proj);
 
+    /// Add the paths of the event data used by the plotter to the vector.
+    void GetEventPaths(std::vector<std::string>& paths) const;
+
 private:
 
     // Draw the TPC hits onto a histogram that was created to draw the digits.
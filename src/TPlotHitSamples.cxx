@@ -1,6 +1,8 @@
 #include "TPlotHitSamples.hxx"
 #include "TEventDisplay.hxx"
 #include "TGUIManager.hxx"
+#include "TEventChangeManager.hxx"
+#include "TDisplayTimer.hxx"
 
 #include <TEvent.hxx>
 #include <THit.hxx>
@@ -33,6 +35,11 @@ CP::TPlotHitSamples::~TPlotHitSamples() {
 }
 
 void CP::TPlotHitSamples::DrawHitSamples() {
+    if (CP::TEventDisplay::Get().EventChange().IsUpdating()) {
+        CaptError("Event update in progress");
+        return;
+    }
+    CP::TDisplayTimer timer("plot", "DrawHitSamples");
     CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
 
     CP::THandle<CP::THitSelection> hits
@@ -1,6 +1,8 @@
 #include "TPlotTimeCharge.hxx"
 #include "TEventDisplay.hxx"
 #include "TGUIManager.hxx"
+#include "TEventChangeManager.hxx"
+#include "TDisplayTimer.hxx"
 
 #include <TEvent.hxx>
 #include <TEventContext.hxx>
@@ -86,6 +88,7 @@ namespace {
 }
 
 void CP::TPlotTimeCharge::FitTimeCharge() {
+    CP::TDisplayTimer timer("plot", "FitTimeCharge");
     TCanvas* canvas = (TCanvas*) gROOT->FindObject("canvasTimeCharge");
     if (!canvas) return;
     
@@ -249,7 +252,21 @@ void CP::TPlotTimeCharge::FitTimeCharge() {
     gPad->Update();
 }
 
+void CP::TPlotTimeCharge::GetEventPaths(
+    std::vector<std::string>& paths) const {
+    paths.push_back("~/hits/drift");
+}
+
 void CP::TPlotTimeCharge::DrawTimeCharge() {
+    if (CP::TEventDisplay::Get().EventChange().IsUpdating()) {
+        CaptError("Event update in progress");
+        return;
+    }
+    CP::TDisplayTimer timer("plot", "DrawTimeCharge");
+    // Make sure the data used by the plot has been read.
+    std::vector<std::string> paths;
+    GetEventPaths(paths);
+    CP::TEventDisplay::Get().EventChange().LoadEventPaths(paths);
 
     CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
 
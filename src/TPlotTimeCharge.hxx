@@ -1,6 +1,7 @@
 #ifndef TPlotTimeCharge_hxx_seen
 #define TPlotTimeCharge_hxx_seen
 #include <vector>
+#include <string>
 
 namespace CP {
     class TPlotTimeCharge;
@@ -25,6 +26,9 @@ public:
     /// Fit the charge vs time in a graph.
     void FitTimeCharge();
 
+    /// Add the paths of the event data used by the plotter to the vector.
+    void GetEventPaths(std::vector<std::string>& paths) const;
+
 private:
 
     /// The graphs...
@@ -0,0 +1,98 @@
+#include "TSampleQuantiles.hxx"
+
+#include <algorithm>
+#include <cmath>
+
+const double CP::TSampleQuantiles::kMinWidth = 1.0/(1<<20);
+
+CP::TSampleQuantiles::TSampleQuantiles()
+    : fCounting(true), fCount(0), fLow(0.0), fWidth(kMinWidth),
+      fMinimum(0.0), fMaximum(0.0) {}
+
+void CP::TSampleQuantiles::Clear() {
+    fCounting = true;
+    fCount = 0;
+    fCounts.clear();
+    fBins.clear();
+    fLow = 0.0;
+    fWidth = kMinWidth;
+    fMinimum = 0.0;
+    fMaximum = 0.0;
+}
+
+void CP::TSampleQuantiles::FillSample(double sample) {
+    if (fCounting) {
+        // Move the counted samples into the histogram.
+        fCounting = false;
+        fBins.assign(kBins, 0);
+        fWidth = kMinWidth;
+        fLow = std::floor(sample/fWidth)*fWidth;
+        fMinimum = sample;
+        fMaximum = sample;
+        for (std::size_t adc = 0; adc < fCounts.size(); ++adc) {
+            if (fCounts[adc] > 0) FillBin(adc, fCounts[adc]);
+        }
+        fCounts.clear();
+    }
+    FillBin(sample, 1);
+    ++fCount;
+}
+
+void CP::TSampleQuantiles::FillBin(double value, unsigned int count) {
+    if (value < fMinimum || value > fMaximum) {
+        fMinimum = std::min(fMinimum, value);
+        fMaximum = std::max(fMaximum, value);
+        if (fMinimum < fLow || fMaximum >= fLow + kBins*fWidth) Rebin();
+    }
+    std::size_t bin = (std::size_t) ((value - fLow)/fWidth);
+    if (bin >= (std::size_t) kBins) bin = kBins - 1;
+    fBins[bin] += count;
+}
+
+void CP::TSampleQuantiles::Rebin() {
+    // Find the narrowest width (doubling the current width) that holds the
+    // samples with the first bin on the grid of the width.  The bins of the
+    // current width then fit exactly inside the new bins.
+    double width = fWidth;
+    double low = std::floor(fMinimum/width)*width;
+    while (fMaximum >= low + kBins*width) {
+        width *= 2.0;
+        low = std::floor(fMinimum/width)*width;
+    }
+
+    std::vector<unsigned int> bins(kBins, 0);
+    for (std::size_t bin = 0; bin < fBins.size(); ++bin) {
+        if (fBins[bin] < 1) continue;
+        double center = fLow + (bin + 0.5)*fWidth;
+        std::size_t target = (std::size_t) ((center - low)/width);
+        if (target >= (std::size_t) kBins) target = kBins - 1;
+        bins[target] += fBins[bin];
+    }
+    fBins.swap(bins);
+    fLow = low;
+    fWidth = width;
+}
+
+double CP::TSampleQuantiles::Quantile(double fraction) const {
+    if (fCount < 1) return 0.0;
+    std::size_t index = fraction*fCount;
+    if (index >= fCount) index = fCount - 1;
+
+    if (fCounting) {
+        std::size_t seen = 0;
+        for (std::size_t adc = 0; adc < fCounts.size(); ++adc) {
+            seen += fCounts[adc];
+            if (index < seen) return adc;
+        }
+        return fCounts.size() - 1;
+    }
+
+    std::size_t seen = 0;
+    for (std::size_t bin = 0; bin < fBins.size(); ++bin) {
+        seen += fBins[bin];
+        if (index >= seen) continue;
+        double center = fLow + (bin + 0.5)*fWidth;
+        return std::min(std::max(center, fMinimum), fMaximum);
+    }
+    return fMaximum;
+}
@@ -0,0 +1,107 @@
+#ifndef TSampleQuantiles_hxx_seen
+#define TSampleQuantiles_hxx_seen
+
+#include <vector>
+#include <cstddef>
+
+namespace CP {
+    class TSampleQuantiles;
+};
+
+/// Find the quantiles of a set of digit samples without sorting them.  As
+/// long as the samples are ADC values (integers in the digitizer range),
+/// they are only counted in one bin per ADC value, and a quantile is found
+/// by walking the counts.  This gives exactly the value that would be at
+/// the same index of the sorted samples.
+///
+/// Once a sample that isn't an ADC value is filled (e.g. a calibrated
+/// sample), the samples are counted in a streaming histogram with kBins
+/// fixed width bins instead, and the ADC counts are moved into it.  The bin
+/// edges are on a grid of the bin width (a power of two), and the width is
+/// doubled (merging pairs of bins) when the spread of the samples no longer
+/// fits, so the width is less than 2*(max-min)/(kBins-1) of the samples
+/// filled so far (or kMinWidth).  A quantile is the center of the bin that
+/// holds it, so it's within half a bin width of the exact value, or about
+/// 6E-5 of the spread of the samples.  The memory used doesn't depend on the
+/// number of samples.
+class CP::TSampleQuantiles {
+public:
+    TSampleQuantiles();
+
+    /// Remove all of the samples.
+    void Clear();
+
+    /// Add a sample.
+    void Fill(double sample) {
+        if (fCounting && sample >= 0.0 && sample < kADCRange) {
+            std::size_t adc = (std::size_t) sample;
+            if (adc == sample) {
+                if (fCounts.empty()) fCounts.resize(kADCRange);
+                ++fCounts[adc];
+                ++fCount;
+                return;
+            }
+        }
+        FillSample(sample);
+    }
+
+    /// Get the number of samples.
+    std::size_t GetCount() const {return fCount;}
+
+    /// Get the sample at the fraction of the sorted samples (i.e. the
+    /// sample at index fraction*GetCount()).  This returns zero if there
+    /// aren't any samples.
+    double Quantile(double fraction) const;
+
+    /// Check if the quantiles are exact (i.e. all of the samples have been
+    /// ADC values).
+    bool IsExact() const {return fCounting;}
+
+    /// Get the tolerance of the quantiles.  This is zero while the
+    /// quantiles are exact, and is otherwise half of the bin width.
+    double GetTolerance() const {return fCounting ? 0.0: 0.5*fWidth;}
+
+    /// The number of ADC values that are counted.
+    enum {kADCRange = 1<<16};
+
+    /// The number of bins in the histogram for samples that aren't ADC
+    /// values.
+    enum {kBins = 1<<14};
+
+private:
+
+    /// The smallest bin width of the histogram.
+    static const double kMinWidth;
+
+    /// Histogram a sample that isn't an ADC value.
+    void FillSample(double sample);
+
+    /// Add a count to the histogram.  The histogram is moved or widened if
+    /// the value is outside of it.
+    void FillBin(double value, unsigned int count);
+
+    /// Move (and widen if needed) the histogram so that it holds the
+    /// samples between fMinimum and fMaximum.
+    void Rebin();
+
+    /// True while all of the samples are ADC values.
+    bool fCounting;
+
+    /// The number of samples.
+    std::size_t fCount;
+
+    /// The number of samples with each ADC value.
+    std::vector<unsigned int> fCounts;
+
+    /// The histogram of the samples once they can't be counted.
+    std::vector<unsigned int> fBins;
+
+    /// The low edge of the first bin, and the bin width.
+    double fLow;
+    double fWidth;
+
+    /// The smallest and largest sample in the histogram.
+    double fMinimum;
+    double fMaximum;
+};
+#endif
@@ -15,14 +15,18 @@ CP::TShowPMTHits::TShowPMTHits(TEveRGBAPalette* palette)
 
 bool CP::TShowPMTHits::operator () (TEveElementList* elements, 
                                     const CP::THitSelection& hits) {
-    
-    TEveBoxSet* boxes = new TEveBoxSet(hits.GetName());
-    boxes->Reset(TEveBoxSet::kBT_AABox, kTRUE, 128);
+    PMTs pmts;
+    FindPMTs(hits, pmts);
+    Boxes boxes;
+    FindBoxes(pmts, boxes);
+    return (*this)(elements, hits.GetName(), boxes);
+}
 
+void CP::TShowPMTHits::FindPMTs(const CP::THitSelection& hits,
+                                PMTs& pmts) {
     std::map<CP::TGeometryId, double > hitCharges;
     std::map<CP::TGeometryId, CP::THandle<CP::THit> > firstHits;
 
-    double maxCharge = 1.0;
     for (CP::THitSelection::const_iterator h = hits.begin();
          h != hits.end(); ++h) {
         CP::THandle<CP::THit> firstHit = firstHits[(*h)->GetGeomId()];
@@ -30,31 +34,59 @@ bool CP::TShowPMTHits::operator () (TEveElementList* elements,
             firstHits[(*h)->GetGeomId()] = *h;
         }
         hitCharges[(*h)->GetGeomId()] += (*h)->GetCharge();
-        maxCharge = std::max(maxCharge, hitCharges[(*h)->GetGeomId()]);
     }
 
-    TVector3 pos; 
     for (std::map<CP::TGeometryId,double>::iterator id = hitCharges.begin();
          id != hitCharges.end(); ++id) {
-        CP::TGeometryId geomId = id->first;
-        double charge = id->second;
+        TVector3 pos = firstHits[id->first]->GetPosition();
+        PMT pmt;
+        pmt.fX = pos.X();
+        pmt.fY = pos.Y();
+        pmt.fZ = pos.Z();
+        pmt.fCharge = id->second;
+        pmts.push_back(pmt);
+    }
+}
+
+void CP::TShowPMTHits::FindBoxes(const PMTs& pmts, Boxes& boxes) {
+    for (PMTs::const_iterator p = pmts.begin(); p != pmts.end(); ++p) {
+        double charge = p->fCharge;
         if (charge<1.0) charge = 1.0;
-        pos = firstHits[geomId]->GetPosition();
+        TVector3 pos(p->fX, p->fY, p->fZ);
         double xyHalf = 10*unit::mm;
         double zHalf = 5*(1.0+9.0*std::log(1.0+charge)/std::log(10.0))*unit::mm;
         double top = 0.0;
         if (pos.Z() < -10*unit::cm) top = -1;
-        boxes->AddBox(pos.X()-xyHalf, 
-                      pos.Y()-xyHalf, 
-                      pos.Z()+2*top*zHalf,
-                      2*xyHalf, 
-                      2*xyHalf,
-                      2*zHalf);
-        boxes->DigitValue(charge);
+        Box box;
+        box.fX = pos.X()-xyHalf;
+        box.fY = pos.Y()-xyHalf;
+        box.fZ = pos.Z()+2*top*zHalf;
+        box.fDX = 2*xyHalf;
+        box.fDY = 2*xyHalf;
+        box.fDZ = 2*zHalf;
+        box.fCharge = charge;
+        boxes.push_back(box);
     }
-    boxes->RefitPlex();
-    
-    elements->AddElement(boxes);
+}
+
+bool CP::TShowPMTHits::operator () (TEveElementList* elements, 
+                                    const std::string& name,
+                                    const Boxes& boxes) {
+    TEveBoxSet* eveBoxes = new TEveBoxSet(name.c_str());
+    FillBoxSet(eveBoxes, name, boxes);
+    elements->AddElement(eveBoxes);
 
     return true;
 }
+
+void CP::TShowPMTHits::FillBoxSet(TEveBoxSet* eveBoxes,
+                                  const std::string& name,
+                                  const Boxes& boxes) {
+    eveBoxes->SetName(name.c_str());
+    eveBoxes->Reset(TEveBoxSet::kBT_AABox, kTRUE, 128);
+    for (Boxes::const_iterator b = boxes.begin(); b != boxes.end(); ++b) {
+        eveBoxes->AddBox(b->fX, b->fY, b->fZ, b->fDX, b->fDY, b->fDZ);
+        eveBoxes->DigitValue(b->fCharge);
+    }
+    eveBoxes->RefitPlex();
+}
@@ -4,11 +4,15 @@
 #include <THitSelection.hxx>
 #include <HEPUnits.hxx>
 
+#include <vector>
+#include <string>
+
 namespace CP {
     class TShowPMTHits;
 };
 
 class TEveElementList;
+class TEveBoxSet;
 class TEveRGBAPalette;
 
 /// Add a set of hits from a hit selection to the provided elements list.  If
@@ -24,6 +28,42 @@ public:
     /// (nominally, this adds a box set).
     bool operator () (TEveElementList* elements, 
                       const CP::THitSelection& hits);
+
+    /// The hits on a PMT.
+    struct PMT {
+        /// The position of the first hit on the PMT.
+        double fX, fY, fZ;
+
+        /// The total charge of the hits on the PMT.
+        double fCharge;
+    };
+    typedef std::vector<PMT> PMTs;
+
+    /// The box drawn for the hits on a PMT.
+    struct Box {
+        float fX, fY, fZ;
+        float fDX, fDY, fDZ;
+        double fCharge;
+    };
+    typedef std::vector<Box> Boxes;
+
+    /// Sum the PMT hits in the selection for each PMT.  The hit positions
+    /// are looked up in the geometry, and the hit handles are shared with
+    /// the event, so this must be called on the GUI thread.
+    static void FindPMTs(const CP::THitSelection& hits, PMTs& pmts);
+
+    /// Find the boxes to draw for the PMTs found by FindPMTs().  This only
+    /// uses the PMT data, so it can be used in a worker thread.
+    static void FindBoxes(const PMTs& pmts, Boxes& boxes);
+
+    /// Show boxes found by FindBoxes() in a box set with the given name.
+    bool operator () (TEveElementList* elements, const std::string& name,
+                      const Boxes& boxes);
+
+    /// Refill an existing box set with boxes found by FindBoxes().  This is
+    /// used to reuse the box set from the previous event.
+    void FillBoxSet(TEveBoxSet* eveBoxes, const std::string& name,
+                    const Boxes& boxes);
 private:
 
     /// The palette to draw with.
@@ -1,6 +1,11 @@
 #include "TTrajectoryChangeHandler.hxx"
 #include "TEventDisplay.hxx"
 #include "TGUIManager.hxx"
+#include "TEventChangeManager.hxx"
+#include "TEveElementPool.hxx"
+#include "TTrajectoryLineSet.hxx"
+#include "TFiducialVolume.hxx"
+#include "TDisplayTimer.hxx"
 
 #include <TCaptLog.hxx>
 #include <TG4Trajectory.hxx>
@@ -9,88 +14,512 @@
 #include <TEventFolder.hxx>
 #include <HEPUnits.hxx>
 #include <THandle.hxx>
+#include <TRuntimeParameters.hxx>
 
 #include <TGeoManager.h>
 #include <TGButton.h>
+#include <TGTextEntry.h>
+#include <TVirtualMutex.h>
+#include <TTimer.h>
+#include <TMath.h>
 
 #include <TEveManager.h>
-#include <TEveLine.h>
+
+#include <TGLViewer.h>
+#include <TGLCamera.h>
+#include <TGLPerspectiveCamera.h>
 
 #include <sstream>
+#include <map>
+#include <limits>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+    /// Add a point to a vector of points.
+    void AddPoint(std::vector<float>& points, const double point[3]) {
+        points.insert(points.end(), point, point+3);
+    }
+
+    /// Find the distance from a point to the segment between two points.
+    /// The points are indices into a vector of points.
+    float SegmentDistance(const std::vector<float>& points,
+                          int point, int begin, int end) {
+        const float* p = &points[3*point];
+        const float* a = &points[3*begin];
+        const float* b = &points[3*end];
+        double ab2 = 0.0;
+        double apab = 0.0;
+        for (int i = 0; i < 3; ++i) {
+            ab2 += (b[i]-a[i])*(b[i]-a[i]);
+            apab += (p[i]-a[i])*(b[i]-a[i]);
+        }
+        double t = 0.0;
+        if (ab2 > 0.0) t = std::max(0.0, std::min(1.0, apab/ab2));
+        double d2 = 0.0;
+        for (int i = 0; i < 3; ++i) {
+            double d = p[i] - (a[i] + t*(b[i]-a[i]));
+            d2 += d*d;
+        }
+        return std::sqrt(d2);
+    }
+
+    /// A range of points to be simplified, and the largest error that can
+    /// be given to the points inside of it.
+    struct Range {
+        int fBegin;
+        int fEnd;
+        float fLimit;
+    };
+
+    /// Fill the errors for the points of a run from begin to end (not
+    /// included).  This is the Douglas-Peucker simplification, except that
+    /// the error of each point is saved instead of cutting at a tolerance.
+    /// The error of a point is never more than the error of the point that
+    /// split its range, so the points kept for any tolerance make the same
+    /// line that Douglas-Peucker would have made.
+    void FillErrors(const std::vector<float>& points,
+                    std::vector<float>& errors,
+                    int begin, int end) {
+        if (end - begin < 1) return;
+        errors[begin] = FLT_MAX;
+        errors[end-1] = FLT_MAX;
+        std::vector<Range> stack;
+        Range all = {begin, end-1, FLT_MAX};
+        stack.push_back(all);
+        while (!stack.empty()) {
+            Range range = stack.back();
+            stack.pop_back();
+            if (range.fEnd - range.fBegin < 2) continue;
+            int split = range.fBegin+1;
+            float error = -1.0;
+            for (int p = range.fBegin+1; p < range.fEnd; ++p) {
+                float d = SegmentDistance(points, p, range.fBegin, range.fEnd);
+                if (d <= error) continue;
+                error = d;
+                split = p;
+            }
+            errors[split] = std::min(error, range.fLimit);
+            Range low = {range.fBegin, split, errors[split]};
+            Range high = {split, range.fEnd, errors[split]};
+            stack.push_back(low);
+            stack.push_back(high);
+        }
+    }
+
+    /// Empty a recycled line set and set its attributes.
+    void ResetLines(CP::TTrajectoryLineSet* lines, const char* name,
+                    Color_t color, Style_t style) {
+        lines->SetName(name);
+        lines->SetLineColor(color);
+        lines->SetLineStyle(style);
+        lines->ResetTrajectories();
+    }
+};
 
-CP::TTrajectoryChangeHandler::TTrajectoryChangeHandler() {
+CP::TTrajectoryChangeHandler::TTrajectoryChangeHandler()
+    : fTrajectoryContainer(NULL), fShowTrajectories(false),
+      fResolvedSerial(-1), fPreparedSerial(-1), fBuiltSerial(-1),
+      fBuiltTolerance(0.0) {
     fTrajectoryList = new TEveElementList("g4Trajectories",
                                           "Geant4 Trajectories");
     fTrajectoryList->SetMainColor(kYellow);
     fTrajectoryList->SetMainAlpha(1.0);
     gEve->AddElement(fTrajectoryList);
+    fTrajectoryPool
+        = new CP::TEveElementPool<CP::TTrajectoryLineSet>(fTrajectoryList);
+
+    fLiquid = new CP::TFiducialVolume("Liquid_");
+    fLiquid->SetVoxelSize(CP::TRuntimeParameters::Get().GetParameterD(
+                              "eventDisplay.trajectories.voxelSize"));
+
+    fPixelError = CP::TRuntimeParameters::Get().GetParameterD(
+        "eventDisplay.trajectories.pixelError");
+
+    // The viewer doesn't say when the camera moves, so check it while the
+    // GUI is idle.
+    fLevelOfDetailTimer = new TTimer(this, 500);
+    fLevelOfDetailTimer->TurnOn();
 }
 
 CP::TTrajectoryChangeHandler::~TTrajectoryChangeHandler() {
+    delete fLevelOfDetailTimer;
+    delete fTrajectoryPool;
+    delete fLiquid;
 }
 
-void CP::TTrajectoryChangeHandler::Apply() {
+void CP::TTrajectoryChangeHandler::GetEventPaths(
+    std::vector<std::string>& paths) const {
+    paths.push_back("truth/G4Trajectories");
+}
 
-    fTrajectoryList->DestroyElements();
+void CP::TTrajectoryChangeHandler::GetControls(
+    std::vector<TGFrame*>& controls) const {
+    controls.push_back(
+        CP::TEventDisplay::Get().GUI().GetShowTrajectoriesButton());
+    controls.push_back(
+        CP::TEventDisplay::Get().GUI().GetTrajectoryFilterField());
+}
 
-    if (!CP::TEventDisplay::Get().GUI().GetShowTrajectoriesButton()->IsOn()) {
-        CaptLog("Trajectories disabled");
-        return;
-    }
+void CP::TTrajectoryChangeHandler::Apply() {
+    Resolve();
+    Prepare();
+    Commit();
+}
+
+void CP::TTrajectoryChangeHandler::Resolve() {
+    fTrajectoryContainer = NULL;
+    fShowTrajectories
+        = CP::TEventDisplay::Get().GUI().GetShowTrajectoriesButton()->IsOn();
+    fResolvedSerial = CP::TEventDisplay::Get().EventChange().GetEventSerial();
+    if (!fShowTrajectories || fPreparedSerial == fResolvedSerial) return;
 
-    CaptLog("Handle the trajectories");
     CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
     if (!event) return;
 
     CP::THandle<CP::TG4TrajectoryContainer> trajectories
         = event->Get<CP::TG4TrajectoryContainer>("truth/G4Trajectories");
-    
+    if (trajectories) fTrajectoryContainer = &(*trajectories);
+}
+
+void CP::TTrajectoryChangeHandler::Prepare() {
+    // Only the state saved by Resolve() is used here.
+    if (!fShowTrajectories) return;
+
+    // The trajectories are only clipped once for each event.  Changing the
+    // filter only needs the lines to be filled again.
+    int serial = fResolvedSerial;
+    if (fPreparedSerial == serial) return;
+    fPreparedSerial = -1;
+    fTrajectories.clear();
+    fMomentumIndex.clear();
+
+    const CP::TG4TrajectoryContainer* trajectories = fTrajectoryContainer;
     if (!trajectories) {
-        CaptLog("No trajectories in event");
+        fPreparedSerial = serial;
         return;
     }
 
-    for (CP::TG4TrajectoryContainer::iterator tPair = trajectories->begin();
+    // The liquid voxels are only rebuilt when the geometry changes.  After
+    // that, the points are checked without the geometry navigator.
+    {
+        TLockGuard lock(CP::TEventDisplay::Get().EventChange()
+                        .GetGeometryMutex());
+        fLiquid->Build(gGeoManager);
+    }
+
+    // Find the parent of each trajectory to find the depth in the decay
+    // tree.
+    std::map<int,int> parents;
+    for (CP::TG4TrajectoryContainer::const_iterator tPair
+             = trajectories->begin();
+         tPair != trajectories->end();
+         ++tPair) {
+        parents[tPair->second.GetTrackId()] = tPair->second.GetParentId();
+    }
+
+    fTrajectories.reserve(trajectories->size());
+    for (CP::TG4TrajectoryContainer::const_iterator tPair
+             = trajectories->begin();
          tPair != trajectories->end();
          ++tPair) {
-        CP::TG4Trajectory& traj = tPair->second;
+        // Stop if a newer event has been requested.
+        if (CP::TEventDisplay::Get().EventChange().IsUpdateCancelled()) {
+            fTrajectories.clear();
+            return;
+        }
+
+        const CP::TG4Trajectory& traj = tPair->second;
         const CP::TG4Trajectory::Points& points = traj.GetTrajectoryPoints();
         const TParticlePDG *pdg = traj.GetParticle();
 
-        bool charged = false;
+        fTrajectories.push_back(Trajectory());
+        Trajectory& trajectory = fTrajectories.back();
+
+        trajectory.fCharged = false;
         if (pdg) {
-            charged = (std::abs(pdg->Charge()) > 0.1);
+            trajectory.fCharged = (std::abs(pdg->Charge()) > 0.1);
+        }
+        trajectory.fMomentum = traj.GetInitialMomentum().P();
+        trajectory.fPDG = traj.GetPDGEncoding();
+        trajectory.fParticle = traj.GetParticleName();
+        trajectory.fTrackId = traj.GetTrackId();
+
+        // Count the ancestors.  A missing ancestor ends the count.
+        trajectory.fDepth = 0;
+        int parent = traj.GetParentId();
+        while (parent > 0 && trajectory.fDepth < 1000) {
+            ++trajectory.fDepth;
+            std::map<int,int>::iterator p = parents.find(parent);
+            if (p == parents.end()) break;
+            parent = p->second;
         }
 
-        std::ostringstream label;
-        label << traj.GetParticleName() 
-              << " (" << traj.GetInitialMomentum().E()/unit::MeV << " MeV)";
+        // Clip the trajectory to the liquid argon.  The points are split
+        // into runs inside the liquid, and a step that crosses the boundary
+        // is cut at the boundary.  A trajectory that leaves and comes back
+        // is not joined across the gap.
+        double last[3] = {0.0, 0.0, 0.0};
+        bool lastInside = false;
+        for (std::size_t p = 0; p < points.size(); ++p) {
+            double point[3] = {points[p].GetPosition().X(),
+                               points[p].GetPosition().Y(),
+                               points[p].GetPosition().Z()};
+            bool inside = fLiquid->Contains(point[0], point[1], point[2]);
+            double boundary[3];
+            if (p < 1) {
+                if (inside) {
+                    trajectory.fRuns.push_back(0);
+                    AddPoint(trajectory.fPoints, point);
+                }
+            }
+            else if (lastInside && inside) {
+                AddPoint(trajectory.fPoints, point);
+            }
+            else if (lastInside) {
+                fLiquid->FindBoundary(last, point, boundary);
+                AddPoint(trajectory.fPoints, boundary);
+            }
+            else if (inside) {
+                fLiquid->FindBoundary(point, last, boundary);
+                trajectory.fRuns.push_back(trajectory.fPoints.size()/3);
+                AddPoint(trajectory.fPoints, boundary);
+                AddPoint(trajectory.fPoints, point);
+            }
+            std::copy(point, point+3, last);
+            lastInside = inside;
+        }
+        if (trajectory.fPoints.empty()) {
+            fTrajectories.pop_back();
+            continue;
+        }
 
-        TEveLine *track = new TEveLine();
-        track->SetName("trajectory");
-        track->SetTitle(label.str().c_str());
-        if (charged) {
-            track->SetLineColor(kYellow);
-            track->SetLineStyle(3);
+        // Find the error made by dropping each point.
+        int count = trajectory.fPoints.size()/3;
+        trajectory.fErrors.resize(count);
+        for (std::size_t r = 0; r < trajectory.fRuns.size(); ++r) {
+            int end = count;
+            if (r+1 < trajectory.fRuns.size()) end = trajectory.fRuns[r+1];
+            FillErrors(trajectory.fPoints, trajectory.fErrors,
+                       trajectory.fRuns[r], end);
+        }
+    }
+
+    for (std::size_t i = 0; i < fTrajectories.size(); ++i) {
+        fMomentumIndex.push_back(i);
+    }
+    std::sort(fMomentumIndex.begin(), fMomentumIndex.end(),
+              MomentumOrder(fTrajectories));
+    fPreparedSerial = serial;
+}
+
+void CP::TTrajectoryChangeHandler::Commit() {
+
+    // Toggling the trajectories only changes whether they are drawn.  The
+    // elements are kept until a different event is shown.
+    bool show
+        = CP::TEventDisplay::Get().GUI().GetShowTrajectoriesButton()->IsOn();
+    fTrajectoryList->SetRnrState(show);
+    if (!show) {
+        CaptLog("Trajectories disabled");
+        return;
+    }
+
+    int serial = CP::TEventDisplay::Get().EventChange().GetEventSerial();
+    std::string filter
+        = CP::TEventDisplay::Get().GUI().GetTrajectoryFilterField()->GetText();
+    if (fBuiltSerial == serial && fBuiltFilter == filter) {
+        CaptLog("Show the trajectories");
+        return;
+    }
+
+    if (fPreparedSerial != serial) {
+        // The button was turned on after the update started, so the
+        // trajectories weren't prepared.  The next update will draw them.
+        fTrajectoryPool->Reset();
+        fBuiltSerial = -1;
+        return;
+    }
+    fBuiltSerial = serial;
+    fBuiltFilter = filter;
+
+    CaptLog("Handle the trajectories");
+    if (fTrajectories.empty()) {
+        fTrajectoryPool->Reset();
+        CaptLog("No trajectories in event");
+        return;
+    }
+
+    FillLines(FindTolerance());
+}
+
+Bool_t CP::TTrajectoryChangeHandler::HandleTimer(TTimer* timer) {
+    // Only redo the lines that are drawn for the current event, and never
+    // while the handlers are being run.
+    if (fBuiltSerial < 0) return kTRUE;
+    if (CP::TEventDisplay::Get().EventChange().IsUpdating()) return kTRUE;
+    if (fBuiltSerial
+        != CP::TEventDisplay::Get().EventChange().GetEventSerial()) {
+        return kTRUE;
+    }
+    if (!fTrajectoryList->GetRnrSelf()) return kTRUE;
+
+    // Only redo the decimation when the tolerance has changed enough to be
+    // seen.
+    double tolerance = FindTolerance();
+    if (tolerance <= 1.5*fBuiltTolerance
+        && 1.5*tolerance >= fBuiltTolerance) return kTRUE;
+
+    CP::TDisplayTimer decimateTimer("trajectories decimate");
+    FillLines(tolerance);
+    gEve->Redraw3D(kFALSE);
+    return kTRUE;
+}
+
+double CP::TTrajectoryChangeHandler::FindTolerance() const {
+    if (fPixelError <= 0.0) return 0.0;
+    TGLViewer* viewer = gEve->GetDefaultGLViewer();
+    if (!viewer) return 0.0;
+    TGLCamera& camera = viewer->CurrentCamera();
+    if (camera.IsCacheDirty()) return 0.0;
+    int height = camera.RefViewport().Height();
+    if (height < 1) return 0.0;
+
+    // The orthographic cameras are used for the projections, and aren't
+    // decimated.
+    TGLPerspectiveCamera* perspective
+        = dynamic_cast<TGLPerspectiveCamera*>(&camera);
+    if (!perspective) return 0.0;
+
+    // The size of a pixel at the distance from the camera to the point it
+    // looks at (the camera center).  The detector isn't at the origin, and
+    // the camera may be centered on a part of the event.
+    TGLVertex3 eye = camera.EyePoint();
+    TGLVector3 center = camera.GetCenterVec();
+    double dx = eye.X() - center.X();
+    double dy = eye.Y() - center.Y();
+    double dz = eye.Z() - center.Z();
+    double distance = std::sqrt(dx*dx + dy*dy + dz*dz);
+    double view = 2.0*distance
+        *std::tan(0.5*perspective->GetFOV()*TMath::DegToRad());
+    return fPixelError*view/height;
+}
+
+void CP::TTrajectoryChangeHandler::FillLines(double tolerance) {
+    fTrajectoryPool->Reset();
+    fBuiltTolerance = tolerance;
+
+    Filter filter;
+    ParseFilter(fBuiltFilter, filter);
+
+    // All of the segments are drawn in two line sets (the line style is set
+    // for the whole set), so there are only two objects to render.  The
+    // line sets remember the trajectory of each segment so that a picked
+    // segment can be described.
+    CP::TTrajectoryLineSet* charged = fTrajectoryPool->Get();
+    ResetLines(charged, "chargedTrajectories", kYellow, 3);
+    CP::TTrajectoryLineSet* neutral = fTrajectoryPool->Get();
+    ResetLines(neutral, "neutralTrajectories", kYellow+4, 4);
+
+    int chargedCount = 0;
+    int neutralCount = 0;
+    int segments = 0;
+    for (std::vector<int>::iterator i = fMomentumIndex.begin();
+         i != fMomentumIndex.end(); ++i) {
+        const Trajectory& t = fTrajectories[*i];
+        // The trajectories are sorted by momentum.
+        if (t.fMomentum <= filter.fMinMomentum) break;
+        if (t.fDepth > filter.fMaxDepth) continue;
+        if (!filter.fAccept.empty() && !filter.fAccept.count(t.fPDG)) {
+            continue;
+        }
+        if (filter.fReject.count(t.fPDG)) continue;
+
+        CP::TTrajectoryLineSet* lines = neutral;
+        if (t.fCharged) {
+            lines = charged;
+            ++chargedCount;
         }
         else {
-            track->SetLineColor(kYellow+4);
-            track->SetLineStyle(4);
+            ++neutralCount;
         }
 
-        for (std::size_t p = 0; p < points.size(); ++p) {
-            gGeoManager->PushPath();
-            gGeoManager->FindNode(points[p].GetPosition().X(),
-                                  points[p].GetPosition().Y(),
-                                  points[p].GetPosition().Z());
-            std::string path(gGeoManager->GetPath());
-            gGeoManager->PopPath();
-            if (path.find("/Liquid_") == std::string::npos) continue;
-            track->SetPoint(p, 
-                            points[p].GetPosition().X(),
-                            points[p].GetPosition().Y(),
-                            points[p].GetPosition().Z());
-        }
-        fTrajectoryList->AddElement(track);
+        CP::TTrajectoryLineSet::Trajectory description;
+        description.fParticle = t.fParticle;
+        description.fMomentum = t.fMomentum;
+        description.fTrackId = t.fTrackId;
+        lines->AddTrajectory(description);
+
+        // Draw the points with an error bigger than the tolerance.  The
+        // ends of each run are always drawn.
+        const std::vector<float>& p = t.fPoints;
+        int count = p.size()/3;
+        for (std::size_t r = 0; r < t.fRuns.size(); ++r) {
+            int end = count;
+            if (r+1 < t.fRuns.size()) end = t.fRuns[r+1];
+            int last = t.fRuns[r];
+            for (int j = last+1; j < end; ++j) {
+                if (t.fErrors[j] < tolerance) continue;
+                lines->AddSegment(&p[3*last], &p[3*j]);
+                last = j;
+                ++segments;
+            }
+        }
+    }
+
+    std::ostringstream title;
+    title << chargedCount << " charged trajectories";
+    charged->SetTitle(title.str().c_str());
+    title.str("");
+    title << neutralCount << " neutral trajectories";
+    neutral->SetTitle(title.str().c_str());
+
+    CaptVerbose("Draw " << chargedCount + neutralCount << " trajectories"
+                << " with " << segments << " segments (tolerance "
+                << tolerance/unit::mm << " mm)");
+}
+
+void CP::TTrajectoryChangeHandler::ParseFilter(const std::string& text,
+                                               Filter& filter) {
+    filter.fMinMomentum = -1.0;
+    filter.fMaxDepth = std::numeric_limits<int>::max();
+    filter.fAccept.clear();
+    filter.fReject.clear();
+
+    std::istringstream clauses(text);
+    std::string clause;
+    while (std::getline(clauses, clause, ';')) {
+        std::istringstream input(clause);
+        std::string what;
+        std::string op;
+        if (!(input >> what)) continue;
+        input >> op;
+        if (what == "momentum" && op == ">") {
+            double momentum;
+            if (input >> momentum) {
+                filter.fMinMomentum = momentum*unit::MeV;
+                continue;
+            }
+        }
+        else if (what == "depth" && op == "<") {
+            int depth;
+            if (input >> depth) {
+                filter.fMaxDepth = depth - 1;
+                continue;
+            }
+        }
+        else if (what == "pdg" && (op == "=" || op == "!=")) {
+            std::set<int>& codes
+                = (op == "=") ? filter.fAccept : filter.fReject;
+            int code;
+            bool found = false;
+            while (input >> code) {
+                codes.insert(code);
+                found = true;
+            }
+            if (found) continue;
+        }
+        CaptError("Invalid trajectory filter: " << clause);
     }
 }
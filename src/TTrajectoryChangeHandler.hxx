@@ -3,26 +3,184 @@
 
 #include "TVEventChangeHandler.hxx"
 
+#include <set>
+
 namespace CP {
     class TTrajectoryChangeHandler;
+    template <class T> class TEveElementPool;
+    class TFiducialVolume;
+    class TG4TrajectoryContainer;
+    class TTrajectoryLineSet;
 };
 
 class TEveElementList;
+class TTimer;
 
-/// Handle drawing the trajectories.
+/// Handle drawing the trajectories.  The trajectories can be filtered by
+/// their initial momentum, PDG code and depth in the decay tree (see
+/// TGUIManager::GetTrajectoryFilterField()).  The trajectory points are
+/// decimated so that the error on the screen stays below a few pixels,
+/// and the decimation is redone when the camera moves.
 class CP::TTrajectoryChangeHandler: public TVEventChangeHandler {
 public:
     TTrajectoryChangeHandler();
     ~TTrajectoryChangeHandler();
 
+    /// The name of the handler used in timing reports.
+    virtual const char* GetName() const {return "trajectories";}
+
+    /// The handler is detailed, so it's drawn after the coarse handlers.
+    virtual int GetDetailLevel() const {return 1;}
+
     /// Draw the trajectories into the current scene.
    virtual void Apply();
 
+    /// The trajectories are clipped in a worker thread.
+    virtual bool HasPrepare() const {return true;}
+
+    /// Find the trajectories in the event, and save the state of the GUI for
+    /// Prepare().
+    virtual void Resolve();
+
+    /// Clip the trajectories of a new event to the liquid argon.
+    virtual void Prepare();
+
+    /// Fill the EVE line sets for the selected trajectories.
+    virtual void Commit();
+
+    /// Declare the event data used by the handler.
+    virtual void GetEventPaths(std::vector<std::string>& paths) const;
+
+    /// Declare the GUI controls used by the handler.
+    virtual void GetControls(std::vector<TGFrame*>& controls) const;
+
+    /// Check if the camera has moved enough to change the decimation.  This
+    /// is called by the level of detail timer.
+    virtual Bool_t HandleTimer(TTimer* timer);
+
 private:
 
+    /// The selection of the trajectories to draw.
+    struct Filter {
+        /// The minimum initial momentum.
+        double fMinMomentum;
+
+        /// The maximum depth in the decay tree.
+        int fMaxDepth;
+
+        /// The PDG codes to draw (all if empty).
+        std::set<int> fAccept;
+
+        /// The PDG codes to skip.
+        std::set<int> fReject;
+    };
+
+    /// Parse the trajectory filter text.  Bad conditions are reported and
+    /// ignored.
+    static void ParseFilter(const std::string& text, Filter& filter);
+
+    /// Find the distance at the detector that is the allowed pixel error on
+    /// the screen.  This returns zero if it can't be found (e.g. the viewer
+    /// hasn't been drawn yet).
+    double FindTolerance() const;
+
+    /// Fill the line sets with the selected trajectories decimated to the
+    /// tolerance.
+    void FillLines(double tolerance);
+
     /// The trajectories to draw in the event.
     TEveElementList* fTrajectoryList;
 
+    /// The line sets used to draw the trajectories.  They are reused for
+    /// each event.
+    CP::TEveElementPool<CP::TTrajectoryLineSet>* fTrajectoryPool;
+
+    /// The trajectories found by Resolve(), or NULL.
+    const CP::TG4TrajectoryContainer* fTrajectoryContainer;
+
+    /// The state of the "Show Trajectories" button when Resolve() was
+    /// called.  The GUI is still running during Prepare(), so the button
+    /// isn't read by the worker thread.
+    bool fShowTrajectories;
+
+    /// The serial number of the event when Resolve() was called.
+    int fResolvedSerial;
+
+    /// The serial number of the event that the trajectories were prepared
+    /// for, or -1.
+    int fPreparedSerial;
+
+    /// The serial number of the event that the lines were built for, or -1.
+    int fBuiltSerial;
+
+    /// The filter text used to build the lines.
+    std::string fBuiltFilter;
+
+    /// The decimation tolerance used to build the lines.
+    double fBuiltTolerance;
+
+    /// The liquid argon used to select the trajectory points to draw.
+    CP::TFiducialVolume* fLiquid;
+
+    /// The error (in pixels) allowed when the points are decimated.
+    double fPixelError;
+
+    /// The timer that checks for camera changes.
+    TTimer* fLevelOfDetailTimer;
+
+    /// The display data for a trajectory.
+    struct Trajectory {
+        /// True if the particle is charged.
+        bool fCharged;
+
+        /// The initial momentum.
+        double fMomentum;
+
+        /// The PDG code of the particle.
+        int fPDG;
+
+        /// The name of the particle.
+        std::string fParticle;
+
+        /// The track id of the trajectory.
+        int fTrackId;
+
+        /// The number of ancestors of the trajectory.
+        int fDepth;
+
+        /// The points of the trajectory clipped to the liquid argon.  Each
+        /// point is three values.
+        std::vector<float> fPoints;
+
+        /// The error made by dropping each point (the distance from the
+        /// point to the simplified line).  The points with an error larger
+        /// than the tolerance are drawn.  The ends of the runs are always
+        /// drawn.
+        std::vector<float> fErrors;
+
+        /// The index of the first point of each run of points inside the
+        /// liquid.
+        std::vector<int> fRuns;
+    };
+
+    /// Order the trajectory indices by decreasing momentum.
+    struct MomentumOrder {
+        explicit MomentumOrder(const std::vector<Trajectory>& t)
+            : fTrajectories(t) {}
+        bool operator () (int a, int b) const {
+            return fTrajectories[a].fMomentum > fTrajectories[b].fMomentum;
+        }
+        const std::vector<Trajectory>& fTrajectories;
+    };
+
+    /// The trajectories found by Prepare().  They are kept until the next
+    /// event so that the filter can be changed without clipping them again.
+    std::vector<Trajectory> fTrajectories;
+
+    /// The indices of the trajectories sorted by decreasing momentum, so
+    /// that the loop over the trajectories ends at the momentum cut.
+    std::vector<int> fMomentumIndex;
+
 };
 
 #endif
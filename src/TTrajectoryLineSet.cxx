@@ -0,0 +1,59 @@
+#include "TTrajectoryLineSet.hxx"
+
+#include <TCaptLog.hxx>
+#include <TUnitsTable.hxx>
+
+#include <TGLSelectRecord.h>
+
+#include <sstream>
+
+ClassImp(CP::TTrajectoryLineSet);
+ClassImp(CP::TTrajectoryLineSetGL);
+
+CP::TTrajectoryLineSet::TTrajectoryLineSet()
+    : TEveStraightLineSet("trajectories") {}
+
+CP::TTrajectoryLineSet::~TTrajectoryLineSet() {}
+
+void CP::TTrajectoryLineSet::ResetTrajectories() {
+    fTrajectories.clear();
+    fLineTrajectory.clear();
+    GetLinePlex().Reset(sizeof(TEveStraightLineSet::Line_t), 1024);
+}
+
+void CP::TTrajectoryLineSet::AddTrajectory(const Trajectory& trajectory) {
+    fTrajectories.push_back(trajectory);
+}
+
+void CP::TTrajectoryLineSet::AddSegment(const float start[3],
+                                        const float stop[3]) {
+    // The line id is the index of the segment.
+    AddLine(start[0], start[1], start[2], stop[0], stop[1], stop[2]);
+    fLineTrajectory.push_back(fTrajectories.size()-1);
+}
+
+std::string CP::TTrajectoryLineSet::GetTrajectoryTitle(int line) const {
+    if (line < 0 || line >= (int) fLineTrajectory.size()) return "";
+    int index = fLineTrajectory[line];
+    if (index < 0 || index >= (int) fTrajectories.size()) return "";
+    const Trajectory& trajectory = fTrajectories[index];
+
+    std::ostringstream title;
+    title << "Trajectory " << trajectory.fParticle
+          << " (" << unit::AsString(trajectory.fMomentum, "momentum") << ")"
+          << " track " << trajectory.fTrackId;
+    return title.str();
+}
+
+void CP::TTrajectoryLineSetGL::ProcessSelection(TGLRnrCtx& rnrCtx,
+                                                TGLSelectRecord& rec) {
+    // The names for a line are the object, one (for a line), and the line
+    // id.
+    if (rec.GetN() != 3 || rec.GetItem(1) != 1) return;
+    CP::TTrajectoryLineSet* lines
+        = dynamic_cast<CP::TTrajectoryLineSet*>(fExternalObj);
+    if (!lines) return;
+    std::string title = lines->GetTrajectoryTitle(rec.GetItem(2));
+    CaptLog(title);
+    lines->SetTitle(title.c_str());
+}
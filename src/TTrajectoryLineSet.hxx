@@ -0,0 +1,80 @@
+#ifndef TTrajectoryLineSet_hxx_seen
+#define TTrajectoryLineSet_hxx_seen
+
+#include <TEveStraightLineSet.h>
+#include <TEveStraightLineSetGL.h>
+
+#include <vector>
+#include <string>
+
+namespace CP {
+    class TTrajectoryLineSet;
+    class TTrajectoryLineSetGL;
+};
+
+/// A set of trajectory segments drawn as one EVE object.  Many trajectories
+/// are drawn in the same set, so the trajectory of each segment is kept next
+/// to the line.  The trajectory is only described when a segment is picked
+/// (see TTrajectoryLineSetGL), and the description then becomes the title of
+/// the set so that it's shown as the tooltip.
+class CP::TTrajectoryLineSet: public TEveStraightLineSet {
+public:
+    /// The information used to describe a trajectory.
+    struct Trajectory {
+        /// The name of the particle.
+        std::string fParticle;
+
+        /// The initial momentum.
+        double fMomentum;
+
+        /// The track id of the trajectory.
+        int fTrackId;
+    };
+
+    TTrajectoryLineSet();
+    virtual ~TTrajectoryLineSet();
+
+    /// Remove all of the trajectories so that the set can be refilled.
+    void ResetTrajectories();
+
+    /// Start a new trajectory.  The segments added after this belong to the
+    /// trajectory.
+    void AddTrajectory(const Trajectory& trajectory);
+
+    /// Add a segment of the last trajectory.
+    void AddSegment(const float start[3], const float stop[3]);
+
+    /// Get the number of trajectories.
+    int GetTrajectoryCount() const {return fTrajectories.size();}
+
+    /// Make the description of the trajectory of a segment.
+    std::string GetTrajectoryTitle(int line) const;
+
+private:
+
+    /// The trajectories in the order they were added.
+    std::vector<Trajectory> fTrajectories;
+
+    /// The index of the trajectory for each line.
+    std::vector<int> fLineTrajectory;
+
+    ClassDef(TTrajectoryLineSet,0);
+};
+
+/// The GL renderer for a TTrajectoryLineSet.  The lines are always picked
+/// individually, and the trajectory of the picked line becomes the title of
+/// the set.
+class CP::TTrajectoryLineSetGL: public TEveStraightLineSetGL {
+public:
+    TTrajectoryLineSetGL() {}
+    virtual ~TTrajectoryLineSetGL() {}
+
+    /// Always pick the individual segments.
+    virtual Bool_t AlwaysSecondarySelect() const {return kTRUE;}
+
+    /// Describe the trajectory that was picked.
+    virtual void ProcessSelection(TGLRnrCtx& rnrCtx, TGLSelectRecord& rec);
+
+    ClassDef(TTrajectoryLineSetGL,0);
+};
+#endif
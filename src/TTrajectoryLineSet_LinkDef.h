@@ -0,0 +1,4 @@
+#ifdef __CINT__
+#pragma link C++ class CP::TTrajectoryLineSet+;
+#pragma link C++ class CP::TTrajectoryLineSetGL+;
+#endif
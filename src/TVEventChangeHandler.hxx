@@ -3,15 +3,22 @@
 
 #include <TObject.h>
 
+#include <vector>
+#include <string>
+
 namespace CP {
     class TVEventChangeHandler;
 };
 
+class TGFrame;
+
 /// A base class for handlers called by TEventChangeManager.  The
 /// TEventChangeManager keeps a vector of possible handlers that are used
 /// everytime the event has changed (or needs to be reset).  The handlers need
 /// to implement the XXX class, and should check to see if they are enabled
-/// using the GUI class.
+/// using the GUI class.  The work of a handler can be split into a Prepare()
+/// phase that is run in a worker thread, and a Commit() phase that is run
+/// on the GUI thread.
 class CP::TVEventChangeHandler: public TObject {
 public:
     TVEventChangeHandler() {}
@@ -20,5 +27,52 @@ public:
     /// Apply the change handler to the current event.  This does all of the
     /// work.
     virtual void Apply() = 0;
+
+    /// Return true if the handler splits its work into Prepare() and
+    /// Commit().  The TEventChangeManager only starts a thread for the
+    /// handlers that return true, and the others are applied on the GUI
+    /// thread once the threads have finished.
+    virtual bool HasPrepare() const {return false;}
+
+    /// Find the event data used by Prepare().  This is run on the GUI thread
+    /// just before Prepare() is started in a worker.  The event isn't thread
+    /// safe, so every lookup in the event (e.g. TEvent::Get()) must be done
+    /// here, and the handler keeps raw const pointers to the data.  The
+    /// pointers are only valid until Prepare() returns.
+    virtual void Resolve() {}
+
+    /// Compute the display data (positions, colors, titles) for the current
+    /// event.  The TEventChangeManager runs the Prepare() method of every
+    /// update handler at the same time in separate threads, so this must
+    /// only read the data found by Resolve() and fill members of the
+    /// handler.  It must not look anything up in the event, create EVE
+    /// objects, or change the GUI.  Geometry navigation must be done while
+    /// holding the TEventChangeManager geometry mutex.
+    virtual void Prepare() {}
+
+    /// Create the EVE objects from the data computed by Prepare().  This is
+    /// run on the GUI thread after the handler has been prepared.  The
+    /// default calls Apply() so that a handler that doesn't split the work
+    /// does everything on the GUI thread.
+    virtual void Commit() {Apply();}
+
+    /// Get the level of detail drawn by the handler.  The coarse handlers
+    /// (level zero) are committed and drawn as soon as they are prepared,
+    /// and the detailed handlers (e.g. the trajectories) are committed once
+    /// every handler is prepared.  A handler with a long Prepare() should
+    /// check TEventChangeManager::IsUpdateCancelled() and stop early.
+    virtual int GetDetailLevel() const {return 0;}
+
+    /// Add the paths of the event data used by this handler to the vector
+    /// (e.g. "hits/pmt").  The paths are relative to the event.  Data in the
+    /// pruned folders (e.g. "digits") is only kept in the prefetched and
+    /// cached events when some handler declares that it's needed.
+    virtual void GetEventPaths(std::vector<std::string>& paths) const {}
+
+    /// Add the GUI controls (e.g. the "Show G4 Hits" check button) that
+    /// change what the handler draws.  The TEventChangeManager only reruns
+    /// an update handler when the event changes, or when the state of one of
+    /// its controls has changed since it was last run.
+    virtual void GetControls(std::vector<TGFrame*>& controls) const {}
 };
 #endif
@@ -0,0 +1,20 @@
+#ifndef TVEventPredicate_hxx_seen
+#define TVEventPredicate_hxx_seen
+
+namespace CP {
+    class TVEventPredicate;
+    class TEvent;
+};
+
+/// A base class for the conditions used by TEventSearch to select events.
+/// The search tests events in several threads at once, so the predicate
+/// must not change any state when it is applied.
+class CP::TVEventPredicate {
+public:
+    TVEventPredicate() {}
+    virtual ~TVEventPredicate() {}
+
+    /// Return true if the event is selected.
+    virtual bool operator () (CP::TEvent& event) const = 0;
+};
+#endif
@@ -0,0 +1,32 @@
+#include <tut.h>
+#include <tut_reporter.h>
+
+#include <iostream>
+#include <string>
+
+namespace tut {
+    test_runner_singleton runner;
+}
+
+/// Run the unit tests for the event display.  If a group name is given on
+/// the command line, then only that group is run.
+int main(int argc, char** argv) {
+    tut::reporter visi;
+    tut::runner.get().set_callback(&visi);
+
+    try {
+        if (argc > 1) {
+            tut::runner.get().run_tests(std::string(argv[1]));
+        }
+        else {
+            tut::runner.get().run_tests();
+        }
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "eventDisplayTUT raised exception: " << ex.what()
+                  << std::endl;
+        return 1;
+    }
+
+    return visi.all_ok() ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+#include <tut.h>
+
+#include "TDriftVolume.hxx"
+
+#include <TGeoManager.h>
+#include <TGeoMaterial.h>
+#include <TGeoMedium.h>
+#include <TGeoVolume.h>
+#include <TGeoMatrix.h>
+#include <TGeoPgon.h>
+#include <TGeoNode.h>
+
+#include <vector>
+
+namespace tut {
+    /// Build a small geometry with a drift volume in the world, and check
+    /// the drift volume test against the navigator.
+    struct baseTDriftVolume {
+        baseTDriftVolume() {
+            fGeometry = new TGeoManager("tutTDriftVolume",
+                                        "Drift volume test geometry");
+            TGeoMaterial* vacuum = new TGeoMaterial("vacuum",0,0,0);
+            TGeoMedium* medium = new TGeoMedium("vacuum",1,vacuum);
+            fWorld = fGeometry->MakeBox("world",medium,200,200,200);
+            fGeometry->SetTopVolume(fWorld);
+
+            // A hexagonal drift volume with a wire plane inside.
+            fDrift = fGeometry->MakePgon("drift",medium,0,360,6,2);
+            TGeoPgon* pgon = static_cast<TGeoPgon*>(fDrift->GetShape());
+            pgon->DefineSection(0,-40,0,50);
+            pgon->DefineSection(1,40,0,50);
+            TGeoVolume* plane = fGeometry->MakeBox("plane",medium,30,30,1);
+            fDrift->AddNode(plane,1,new TGeoTranslation(0,0,30));
+
+            // A box drift volume without daughters.
+            fBox = fGeometry->MakeBox("box",medium,20,10,5);
+
+            TGeoRotation* rotation = new TGeoRotation("rotation",30,20,10);
+            fWorld->AddNode(fDrift,1,new TGeoCombiTrans(5,-3,2,rotation));
+            fWorld->AddNode(fBox,1,new TGeoCombiTrans(0,120,0,rotation));
+            fGeometry->CloseGeometry();
+        }
+
+        ~baseTDriftVolume() {
+            delete fGeometry;
+        }
+
+        /// Set the drift volume from the node at a path.
+        void SetVolume(CP::TDriftVolume& drift, const char* path) {
+            fGeometry->cd(path);
+            drift.SetVolume(*fGeometry->GetCurrentMatrix(),
+                            *fGeometry->GetCurrentVolume());
+        }
+
+        /// Compare the drift volume test to the navigator on a grid of
+        /// points around a volume.  The number of points that need the
+        /// navigator is returned in "check".
+        int CountDifferences(const CP::TDriftVolume& drift,
+                             const TGeoVolume* volume,
+                             double center[3], double size,
+                             int& check) {
+            const int steps = 20;
+            int differences = 0;
+            check = 0;
+            for (int i = 0; i < steps; ++i) {
+                for (int j = 0; j < steps; ++j) {
+                    for (int k = 0; k < steps; ++k) {
+                        double x = center[0] + size*((i+0.5)/steps - 0.5);
+                        double y = center[1] + size*((j+0.5)/steps - 0.5);
+                        double z = center[2] + size*((k+0.5)/steps - 0.5);
+                        int fast = drift.Classify(x,y,z);
+                        if (fast == CP::TDriftVolume::kCheck) {
+                            ++check;
+                            continue;
+                        }
+                        fGeometry->FindNode(x,y,z);
+                        bool inside
+                            = (fGeometry->GetCurrentVolume() == volume);
+                        bool fastInside = (fast == CP::TDriftVolume::kInside);
+                        if (inside != fastInside) ++differences;
+                    }
+                }
+            }
+            return differences;
+        }
+
+        TGeoManager* fGeometry;
+        TGeoVolume* fWorld;
+        TGeoVolume* fDrift;
+        TGeoVolume* fBox;
+    };
+
+    typedef test_group<baseTDriftVolume>::object testTDriftVolume;
+    test_group<baseTDriftVolume> groupTDriftVolume("TDriftVolume");
+
+    // Test that an empty drift volume sends every point to the navigator.
+    template<> template<> void testTDriftVolume::test<1> () {
+        CP::TDriftVolume drift;
+        ensure_equals("Unbuilt volume must be checked",
+                      drift.Classify(0.0,0.0,0.0),
+                      (int) CP::TDriftVolume::kCheck);
+    }
+
+    // Test a rotated polygon drift volume with a daughter.
+    template<> template<> void testTDriftVolume::test<2> () {
+        CP::TDriftVolume drift;
+        SetVolume(drift,"/world_1/drift_1");
+        double center[3] = {5.0, -3.0, 2.0};
+        int check = 0;
+        int differences = CountDifferences(drift,fDrift,center,160.0,check);
+        ensure_equals("Drift volume test matches the navigator",
+                      differences, 0);
+        ensure("Points in the daughter are checked", check > 0);
+    }
+
+    // Test a rotated box drift volume, and that the batch classification
+    // matches the single point classification.
+    template<> template<> void testTDriftVolume::test<3> () {
+        CP::TDriftVolume drift;
+        SetVolume(drift,"/world_1/box_1");
+        double center[3] = {0.0, 120.0, 0.0};
+        int check = 0;
+        int differences = CountDifferences(drift,fBox,center,60.0,check);
+        ensure_equals("Box volume test matches the navigator",
+                      differences, 0);
+        ensure_equals("Box volume without daughters is exact", check, 0);
+
+        std::vector<double> x;
+        std::vector<double> y;
+        std::vector<double> z;
+        for (int i = 0; i < 1000; ++i) {
+            x.push_back(center[0] + 6.0*(i%10 - 4.5));
+            y.push_back(center[1] + 6.0*((i/10)%10 - 4.5));
+            z.push_back(center[2] + 6.0*(i/100 - 4.5));
+        }
+        std::vector<unsigned char> result(x.size());
+        drift.Classify(x.size(),&x[0],&y[0],&z[0],&result[0]);
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            ensure_equals("Batch matches single point classification",
+                          (int) result[i],
+                          drift.Classify(x[i],y[i],z[i]));
+        }
+    }
+
+    // Test points just inside, on, and just outside of each face of the
+    // rotated box.  The points are much closer to the boundary than the
+    // precision of a float, so they must be classified in double precision
+    // to match the navigator.
+    template<> template<> void testTDriftVolume::test<4> () {
+        CP::TDriftVolume drift;
+        SetVolume(drift,"/world_1/box_1");
+        const TGeoMatrix* matrix = fGeometry->GetCurrentMatrix();
+        const double half[3] = {20.0, 10.0, 5.0};
+        const double offset[3] = {-1E-7, 0.0, 1E-7};
+
+        std::vector<double> x;
+        std::vector<double> y;
+        std::vector<double> z;
+        std::vector<int> expected;
+        for (int axis = 0; axis < 3; ++axis) {
+            for (int side = -1; side <= 1; side += 2) {
+                for (int o = 0; o < 3; ++o) {
+                    double local[3] = {0.3*half[0], -0.2*half[1], 0.1*half[2]};
+                    local[axis] = side*(half[axis] + offset[o]);
+                    double master[3];
+                    matrix->LocalToMaster(local,master);
+                    x.push_back(master[0]);
+                    y.push_back(master[1]);
+                    z.push_back(master[2]);
+                    if (offset[o] < 0.0) {
+                        expected.push_back(CP::TDriftVolume::kInside);
+                    }
+                    else if (offset[o] > 0.0) {
+                        expected.push_back(CP::TDriftVolume::kOutside);
+                    }
+                    else expected.push_back(-1);
+                }
+            }
+        }
+
+        std::vector<unsigned char> result(x.size());
+        drift.Classify(x.size(),&x[0],&y[0],&z[0],&result[0]);
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            ensure_equals("Boundary batch matches single point",
+                          (int) result[i],
+                          drift.Classify(x[i],y[i],z[i]));
+            // A point exactly on the boundary can go either way.
+            if (expected[i] < 0) continue;
+            ensure_equals("Boundary point classification",
+                          (int) result[i], expected[i]);
+            fGeometry->FindNode(x[i],y[i],z[i]);
+            bool inside = (fGeometry->GetCurrentVolume() == fBox);
+            ensure_equals("Boundary point matches the navigator",
+                          inside,
+                          (result[i] == CP::TDriftVolume::kInside));
+        }
+    }
+};
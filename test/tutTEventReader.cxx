@@ -0,0 +1,128 @@
+#include <tut.h>
+
+#include "TEventReader.hxx"
+#include "TEventTree.hxx"
+
+#include <TEvent.hxx>
+#include <TEventContext.hxx>
+#include <TRootInput.hxx>
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TDirectory.h>
+#include <TSystem.h>
+
+#include <sstream>
+#include <string>
+
+namespace tut {
+    /// Write a file of events that grows while it is being read, the way
+    /// that the file is written when the event display follows it.
+    struct baseTEventReader {
+        baseTEventReader()
+            : fRun(123), fFile(NULL), fTree(NULL), fEvent(NULL) {
+            std::ostringstream name;
+            name << gSystem->TempDirectory() << "/tutTEventReader"
+                 << gSystem->GetPid() << ".root";
+            fFileName = name.str();
+
+            TDirectory* saveDirectory = gDirectory;
+            fFile = new TFile(fFileName.c_str(), "RECREATE");
+            fTree = new TTree("captainEventTree", "Growing event tree");
+            fEvent = new CP::TEvent();
+            fTree->Branch("Event", "CP::TEvent", &fEvent, 64000, 1);
+            delete fEvent;
+            fEvent = NULL;
+            if (saveDirectory) saveDirectory->cd();
+        }
+
+        ~baseTEventReader() {
+            if (fFile) delete fFile;
+            gSystem->Unlink(fFileName.c_str());
+        }
+
+        /// Write events to the file.  The event numbers count from "first".
+        /// The tree is saved so that a reader can see the events unless
+        /// "save" is false.
+        void WriteEvents(int first, int count, bool save = true) {
+            for (int i = first; i < first+count; ++i) {
+                CP::TEventContext context;
+                context.SetRun(fRun);
+                context.SetEvent(i);
+                fEvent = new CP::TEvent(context);
+                fTree->SetBranchAddress("Event", &fEvent);
+                fTree->Fill();
+                delete fEvent;
+                fEvent = NULL;
+            }
+            if (!save) return;
+            fTree->AutoSave("SaveSelf");
+            fFile->Flush();
+        }
+
+        /// The run number of the events that are written.
+        int fRun;
+
+        std::string fFileName;
+        TFile* fFile;
+        TTree* fTree;
+        CP::TEvent* fEvent;
+    };
+
+    typedef test_group<baseTEventReader>::object testTEventReader;
+    test_group<baseTEventReader> groupTEventReader("TEventReader");
+
+    // Test that the tree sees the entries written after it was opened once
+    // it has been refreshed.
+    template<> template<> void testTEventReader::test<1> () {
+        WriteEvents(0,3);
+        CP::TEventTree tree(fFileName);
+        ensure("Tree of events is found", tree.IsOpen());
+        ensure_equals("Entries when opened", tree.GetEntryCount(), 3);
+
+        WriteEvents(3,4);
+        tree.Refresh();
+        ensure_equals("Entries after refresh", tree.GetEntryCount(), 7);
+        int run = -1;
+        int event = -1;
+        ensure("Newest entry is read", tree.ReadContext(6,run,event));
+        ensure_equals("Newest entry run", run, fRun);
+        ensure_equals("Newest entry event", event, 6);
+    }
+
+    // Test that a reader following a file jumps to the newest complete
+    // entry, and that the entries already read are unchanged.
+    template<> template<> void testTEventReader::test<2> () {
+        WriteEvents(0,2);
+        CP::TRootInput input(fFileName.c_str());
+        CP::TEventReader reader(&input);
+        ensure("Events are read directly", reader.HasDirectRead());
+        ensure_equals("Entries when opened", reader.GetEntryCount(), 2);
+
+        for (int pass = 0; pass < 3; ++pass) {
+            int first = reader.GetEntryCount();
+            WriteEvents(first, 5);
+            reader.Refresh();
+            int last = reader.GetEntryCount() - 1;
+            ensure_equals("Newest entry after refresh", last, first+4);
+
+            CP::TEvent* event = reader.ReadEntry(last);
+            ensure("Newest entry is read", event != NULL);
+            ensure_equals("Newest entry event",
+                          event->GetContext().GetEvent(), last);
+            delete event;
+        }
+
+        CP::TEvent* event = reader.ReadEntry(1);
+        ensure("Old entry is read", event != NULL);
+        ensure_equals("Old entry event", event->GetContext().GetEvent(), 1);
+        delete event;
+
+        // An entry that is written isn't seen until the tree is saved.
+        int entries = reader.GetEntryCount();
+        WriteEvents(entries, 1, false);
+        reader.Refresh();
+        ensure_equals("Unsaved entry isn't seen",
+                      reader.GetEntryCount(), entries);
+    }
+};
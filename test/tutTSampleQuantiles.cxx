@@ -0,0 +1,128 @@
+#include <tut.h>
+
+#include "TSampleQuantiles.hxx"
+
+#include <TRandom3.h>
+
+#include <vector>
+#include <algorithm>
+#include <ctime>
+#include <cmath>
+
+namespace tut {
+    /// Compare the sample quantiles to the value at the same index of the
+    /// sorted samples (the way the digit plot found them before).
+    struct baseTSampleQuantiles {
+        baseTSampleQuantiles() : fRandom(4357) {}
+
+        /// Find a quantile by sorting the samples.
+        double SortedQuantile(std::vector<double> samples, double fraction) {
+            std::sort(samples.begin(), samples.end());
+            return samples[fraction*samples.size()];
+        }
+
+        /// Fill raw digit samples (a pedestal with a few pulses).
+        void FillADC(std::vector<double>& samples, int count) {
+            for (int i = 0; i < count; ++i) {
+                double s = fRandom.Gaus(2048.0, 20.0);
+                if (i%5000 < 50) s += 1000.0*fRandom.Exp(1.0);
+                samples.push_back(std::floor(std::min(4095.0,s)));
+            }
+        }
+
+        /// Fill calibrated digit samples (charge around zero with a few
+        /// pulses).
+        void FillCalib(std::vector<double>& samples, int count) {
+            for (int i = 0; i < count; ++i) {
+                double s = fRandom.Gaus(0.0, 350.0);
+                if (i%5000 < 50) s += 2.0E+4*fRandom.Exp(1.0);
+                samples.push_back(s);
+            }
+        }
+
+        TRandom3 fRandom;
+    };
+
+    typedef test_group<baseTSampleQuantiles>::object testTSampleQuantiles;
+    test_group<baseTSampleQuantiles> groupTSampleQuantiles("TSampleQuantiles");
+
+    // Test that the ADC samples give the exact quantiles.
+    template<> template<> void testTSampleQuantiles::test<1> () {
+        std::vector<double> samples;
+        FillADC(samples, 100000);
+        CP::TSampleQuantiles quantiles;
+        for (std::size_t i = 0; i < samples.size(); ++i) {
+            quantiles.Fill(samples[i]);
+        }
+        ensure("ADC samples are exact", quantiles.IsExact());
+        ensure_equals("Sample count", quantiles.GetCount(), samples.size());
+        double fractions[] = {0.0, 0.01, 0.5, 0.99, 1.0};
+        for (int f = 0; f < 5; ++f) {
+            ensure_equals("ADC quantile matches the sorted samples",
+                          quantiles.Quantile(fractions[f]),
+                          SortedQuantile(samples, std::min(fractions[f],
+                                                           0.999999)));
+        }
+    }
+
+    // Test that calibrated samples (and ADC samples followed by calibrated
+    // samples) are within the stated tolerance.
+    template<> template<> void testTSampleQuantiles::test<2> () {
+        std::vector<double> samples;
+        FillADC(samples, 20000);
+        FillCalib(samples, 100000);
+        CP::TSampleQuantiles quantiles;
+        for (std::size_t i = 0; i < samples.size(); ++i) {
+            quantiles.Fill(samples[i]);
+        }
+        ensure("Calibrated samples are histogrammed", !quantiles.IsExact());
+        double low = *std::min_element(samples.begin(), samples.end());
+        double high = *std::max_element(samples.begin(), samples.end());
+        double tolerance = quantiles.GetTolerance();
+        ensure("Tolerance is bounded by the spread",
+               tolerance <= (high-low)/(CP::TSampleQuantiles::kBins-1));
+        double fractions[] = {0.01, 0.25, 0.5, 0.75, 0.99};
+        for (int f = 0; f < 5; ++f) {
+            double expected = SortedQuantile(samples, fractions[f]);
+            double value = quantiles.Quantile(fractions[f]);
+            ensure_distance("Calibrated quantile is within tolerance",
+                            value, expected, 1.0001*tolerance);
+        }
+    }
+
+    // Check that the quantiles are found faster than by sorting the samples.
+    // The samples are filled in one pass, so this holds with a wide margin
+    // for large samples.
+    template<> template<> void testTSampleQuantiles::test<3> () {
+        std::vector<double> adc;
+        FillADC(adc, 2000000);
+        std::vector<double> calib;
+        FillCalib(calib, 2000000);
+        std::vector<double>* inputs[] = {&adc, &calib};
+        for (int n = 0; n < 2; ++n) {
+            const std::vector<double>& samples = *inputs[n];
+
+            std::clock_t start = std::clock();
+            std::vector<double> sorted(samples);
+            std::sort(sorted.begin(), sorted.end());
+            double sortedMedian = sorted[0.5*sorted.size()];
+            double sortTime = double(std::clock() - start)/CLOCKS_PER_SEC;
+
+            start = std::clock();
+            CP::TSampleQuantiles quantiles;
+            for (std::size_t i = 0; i < samples.size(); ++i) {
+                quantiles.Fill(samples[i]);
+            }
+            double median = quantiles.Quantile(0.5);
+            quantiles.Quantile(0.01);
+            quantiles.Quantile(0.99);
+            double quantileTime
+                = double(std::clock() - start)/CLOCKS_PER_SEC;
+
+            ensure_distance("Benchmark medians agree", median, sortedMedian,
+                            1.0001*quantiles.GetTolerance());
+            ensure("Quantiles are faster than sorting",
+                   quantileTime < sortTime);
+        }
+    }
+};